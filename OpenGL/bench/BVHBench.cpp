@@ -0,0 +1,182 @@
+#include "Bench.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <cmath>
+
+#include "../src/BVH.h"
+#include "../src/FrustumCulling.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+static const int Runs = 5;
+static const float SceneSize = 1000.0f;
+
+static std::vector<BoundingBox> RandomBoxes(uint32_t count, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> position(-SceneSize * 0.5f, SceneSize * 0.5f), size(0.5f, 2.0f);
+    std::vector<BoundingBox> boxes(count);
+    for (BoundingBox& box : boxes)
+    {
+        glm::vec3 center(position(random), position(random), position(random));
+        glm::vec3 extent(size(random), size(random), size(random));
+        box = { center - extent, center + extent };
+    }
+    return boxes;
+}
+
+static void BenchBuild(const std::vector<BoundingBox>& boxes)
+{
+    uint32_t count = (uint32_t)boxes.size();
+    BVH bvh;
+    double single = TimeBest(Runs, [&]() { bvh.Build(boxes, 1); });
+    double threaded = TimeBest(Runs, [&]() { bvh.Build(boxes); });
+    std::printf("  build %8u objects %9.3f ms 1 thread %9.3f ms all threads, %u nodes, cost %.1f\n",
+                count, single, threaded, bvh.GetNodeCount(), bvh.GetCost());
+}
+
+// Frustum query and raycasts against brute force over the same boxes
+static void BenchQueries(const std::vector<BoundingBox>& boxes)
+{
+    uint32_t count = (uint32_t)boxes.size();
+    BVH bvh;
+    bvh.Build(boxes);
+
+    BoundingBoxes soa;
+    for (const BoundingBox& box : boxes)
+        soa.Add(box.Min, box.Max);
+
+    //a narrow view from the edge of the scene, the case a hierarchy is for
+    glm::mat4 projection = glm::perspective(glm::radians(30.0f), 16.0f / 9.0f, 0.1f, SceneSize * 1.5f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, SceneSize * 0.6f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(projection * view);
+
+    std::vector<uint32_t> expected, visible;
+    double bruteMs = TimeBest(Runs, [&]() { expected.clear(); FrustumCulling::Cull(frustum, soa, expected); });
+    double bvhMs = TimeBest(Runs, [&]() { visible.clear(); bvh.Query(frustum, visible); });
+    std::sort(visible.begin(), visible.end());
+    std::printf("  query %8u objects %9.3f ms brute force %9.3f ms bvh, %zu visible, %s\n",
+                count, bruteMs, bvhMs, visible.size(), visible == expected ? "match" : "MISMATCH");
+
+    static const int RayCount = 1000;
+    std::mt19937 random(count + 1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> rays(RayCount);
+    for (Ray& ray : rays)
+        ray = { glm::vec3(unit(random), unit(random), unit(random)) * SceneSize * 0.5f,
+                glm::normalize(glm::vec3(unit(random), unit(random), unit(random))) };
+
+    uint32_t hits = 0, mismatches = 0;
+    double rayMs = TimeBest(Runs, [&]()
+    {
+        hits = 0;
+        RayHit hit;
+        for (const Ray& ray : rays)
+            hits += bvh.Raycast(ray, hit) ? 1 : 0;
+    });
+    //brute force only checks the distances, two boxes can be hit at the same one
+    for (int r = 0; r < 100; r++)
+    {
+        const Ray& ray = rays[r];
+        float closest = FLT_MAX;
+        for (const BoundingBox& box : boxes)
+        {
+            glm::vec3 t0 = (box.Min - ray.Origin) / ray.Direction, t1 = (box.Max - ray.Origin) / ray.Direction;
+            glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+            float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+            float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+            if (enter <= exit)
+                closest = std::min(closest, enter);
+        }
+        RayHit hit;
+        bool found = bvh.Raycast(ray, hit);
+        //the bvh multiplies by the inverse direction, so distances can differ in the last bits
+        if (found != (closest != FLT_MAX) || (found && std::abs(hit.Distance - closest) > 1e-4f * std::max(1.0f, closest)))
+            mismatches++;
+    }
+    std::printf("  rays  %8u objects %9.3f us per ray, %u of %d hit, %u of 100 differ from brute force\n",
+                count, rayMs * 1000.0 / RayCount, hits, RayCount, mismatches);
+}
+
+// Moves a fraction of the objects whose box starts below minX, then compares Optimize against a fresh Build
+static void BenchOptimize(const std::vector<BoundingBox>& boxes, const char* name, float minX, float fraction, float distance)
+{
+    static const float MaxDegradation = 1.2f;
+
+    uint32_t count = (uint32_t)boxes.size();
+    std::mt19937 random(count + 2);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f), pick(0.0f, 1.0f);
+
+    std::vector<BoundingBox> moved = boxes;
+    std::vector<uint32_t> movedObjects;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (boxes[i].Min.x >= minX || pick(random) >= fraction)
+            continue;
+        glm::vec3 offset = glm::vec3(unit(random), unit(random), unit(random)) * distance;
+        moved[i].Min += offset;
+        moved[i].Max += offset;
+        movedObjects.push_back(i);
+    }
+
+    //Optimize changes the tree, so every run starts from the original build
+    BVH bvh;
+    double optimizeMs = DBL_MAX;
+    bool rebuilt = false;
+    for (int run = 0; run < Runs; run++)
+    {
+        bvh.Build(boxes);
+        for (uint32_t object : movedObjects)
+            bvh.SetBounds(object, moved[object]);
+        optimizeMs = std::min(optimizeMs, TimeBest(1, [&]() { rebuilt = bvh.Optimize(MaxDegradation); }));
+    }
+
+    BVH refitted;
+    refitted.Build(boxes);
+    for (uint32_t object : movedObjects)
+        refitted.SetBounds(object, moved[object]);
+    refitted.Refit();
+    float refitCost = refitted.GetCost();
+
+    BVH fresh;
+    double buildMs = TimeBest(Runs, [&]() { fresh.Build(moved); });
+
+    //the spliced tree has to find exactly what a scan over the moved boxes finds
+    BoundingBoxes soa;
+    for (const BoundingBox& box : moved)
+        soa.Add(box.Min, box.Max);
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, SceneSize * 1.5f);
+    glm::mat4 view = glm::lookAt(glm::vec3(-SceneSize * 0.6f, 0.0f, SceneSize * 0.3f), glm::vec3(-SceneSize * 0.4f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(projection * view);
+    std::vector<uint32_t> expected, visible;
+    FrustumCulling::Cull(frustum, soa, expected);
+    bvh.Query(frustum, visible);
+    std::sort(visible.begin(), visible.end());
+
+    std::printf("  %-8s %8u objects, %6zu moved: refit cost %.1f, optimize %9.3f ms%s cost %.1f, full build %9.3f ms cost %.1f, query %s\n",
+                name, count, movedObjects.size(), refitCost, optimizeMs, rebuilt ? "" : " (kept)", bvh.GetCost(), buildMs, fresh.GetCost(),
+                visible == expected ? "match" : "MISMATCH");
+}
+
+void RunBVHBench()
+{
+    std::cout << "[Bench] BVH, best of " << Runs << std::endl;
+
+    static const uint32_t counts[] = { 100000, 1000000 };
+    for (uint32_t count : counts)
+    {
+        std::mt19937 random(count);
+        std::vector<BoundingBox> boxes = RandomBoxes(count, random);
+
+        BenchBuild(boxes);
+        BenchQueries(boxes);
+        //half the objects in one end of the scene moving about, some everywhere drifting a little, and a few
+        //jumping across it, which leaves nothing for a partial rebuild to keep
+        BenchOptimize(boxes, "local", -SceneSize * 0.4f, 0.5f, SceneSize * 0.02f);
+        BenchOptimize(boxes, "drift", FLT_MAX, 0.1f, SceneSize * 0.01f);
+        BenchOptimize(boxes, "teleport", FLT_MAX, 0.01f, SceneSize);
+    }
+}
@@ -0,0 +1,42 @@
+#include "Bench.h"
+
+#include <iostream>
+#include <cstring>
+#include <thread>
+
+struct Benchmark
+{
+    const char* Name;
+    void (*Run)();
+};
+
+static const Benchmark s_Benchmarks[] = {
+    { "cull", RunCullBench },
+    { "transform", RunTransformBench },
+    { "bvh", RunBVHBench },
+    { "scenegraph", RunSceneGraphBench }
+};
+
+bool RunBenchmarks(const char* name)
+{
+    std::cout << "[Bench] " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+    bool found = false;
+    for (const Benchmark& benchmark : s_Benchmarks)
+    {
+        if (std::strcmp(name, "all") == 0 || std::strcmp(name, benchmark.Name) == 0)
+        {
+            benchmark.Run();
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        std::cout << "[Bench] Unknown benchmark " << name << ", one of: all";
+        for (const Benchmark& benchmark : s_Benchmarks)
+            std::cout << ", " << benchmark.Name;
+        std::cout << std::endl;
+    }
+    return found;
+}
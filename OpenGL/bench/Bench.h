@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+#include <cfloat>
+#include <algorithm>
+
+// Benchmarks run by starting the application with -bench <name>, before any window or context exists.
+// Each prints a table of what it timed; all of them run for "all".
+bool RunBenchmarks(const char* name);
+
+void RunCullBench();
+void RunTransformBench();
+void RunBVHBench();
+void RunSceneGraphBench();
+
+// Best of runs calls of f, in milliseconds. The best run is the one least disturbed by the rest of the system.
+template<typename F>
+double TimeBest(int runs, F&& f)
+{
+	double best = DBL_MAX;
+	for (int run = 0; run < runs; run++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		f();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
@@ -0,0 +1,118 @@
+#include "Bench.h"
+
+#include <iostream>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../src/FrustumCulling.h"
+#include "../src/CpuFeatures.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+static const int Runs = 5;
+
+// Indices in one sorted list but not the other
+static size_t CountDifferences(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+{
+    size_t differences = 0, i = 0, j = 0;
+    while (i < a.size() && j < b.size())
+    {
+        if (a[i] == b[j])
+            i++, j++;
+        else if (a[i] < b[j])
+            i++, differences++;
+        else
+            j++, differences++;
+    }
+    return differences + (a.size() - i) + (b.size() - j);
+}
+
+static void PrintRow(const char* path, double ms, double referenceMs, uint32_t count, size_t differences)
+{
+    std::printf("  %-14s %9.3f ms %8.1f M/s %6.2fx  %s", path, ms, count / ms / 1000.0, referenceMs / ms, differences ? "" : "match");
+    if (differences)
+        std::printf("%zu differ", differences);
+    std::printf("\n");
+}
+
+// Times every kernel level single threaded, then the best one on all threads, against a plain IsVisible loop
+template<typename Volumes, typename Reference>
+static void BenchVolumes(const char* kind, const Frustum& frustum, const Volumes& volumes, Reference reference)
+{
+    uint32_t count = volumes.GetCount();
+    std::vector<uint32_t> expected, visible;
+    expected.reserve(count);
+    visible.reserve(count);
+
+    double referenceMs = TimeBest(Runs, [&]() { expected.clear(); reference(expected); });
+    std::printf(" %s, %u objects, %zu visible\n", kind, count, expected.size());
+    PrintRow("reference", referenceMs, referenceMs, count, 0);
+
+    static const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 };
+    static const char* names[] = { "scalar", "sse", "avx2" };
+    for (int l = 0; l < 3; l++)
+    {
+        CpuFeatures::SetSimdLevel(levels[l]);
+        if (CpuFeatures::GetSimdLevel() != levels[l])
+        {
+            std::printf("  %-14s not supported\n", names[l]);
+            continue;
+        }
+        double ms = TimeBest(Runs, [&]() { visible.clear(); FrustumCulling::Cull(frustum, volumes, visible, 1); });
+        PrintRow(names[l], ms, referenceMs, count, CountDifferences(expected, visible));
+    }
+
+    CpuFeatures::SetSimdLevel(SimdLevel::AVX2);
+    double ms = TimeBest(Runs, [&]() { visible.clear(); FrustumCulling::Cull(frustum, volumes, visible); });
+    PrintRow("best, threaded", ms, referenceMs, count, CountDifferences(expected, visible));
+}
+
+void RunCullBench()
+{
+    std::cout << "[Bench] Frustum culling, best of " << Runs << std::endl;
+
+    //a camera at the edge of the scene looking across it, a bit over half the objects end up inside
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1500.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 600.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(projection * view);
+
+    static const uint32_t counts[] = { 100000, 1000000, 10000000 };
+    for (uint32_t count : counts)
+    {
+        std::mt19937 random(count);
+        std::uniform_real_distribution<float> position(-500.0f, 500.0f), size(0.5f, 2.0f);
+
+        {
+            BoundingSpheres spheres;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                float x = position(random), y = position(random), z = position(random);
+                spheres.Add(glm::vec3(x, y, z), size(random));
+            }
+            BenchVolumes("spheres", frustum, spheres, [&](std::vector<uint32_t>& visible)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                    if (FrustumCulling::IsVisible(frustum, glm::vec3(spheres.X[i], spheres.Y[i], spheres.Z[i]), spheres.Radius[i]))
+                        visible.push_back(i);
+            });
+        }
+
+        {
+            BoundingBoxes boxes;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                float x = position(random), y = position(random), z = position(random);
+                glm::vec3 center(x, y, z), extent(size(random));
+                boxes.Add(center - extent, center + extent);
+            }
+            BenchVolumes("boxes", frustum, boxes, [&](std::vector<uint32_t>& visible)
+            {
+                for (uint32_t i = 0; i < count; i++)
+                    if (FrustumCulling::IsVisible(frustum, glm::vec3(boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]),
+                                                  glm::vec3(boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i])))
+                        visible.push_back(i);
+            });
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#include "Bench.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../src/SceneGraph.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+static const uint32_t NodeCount = 1000000;
+static const uint32_t GroupSize = 64;
+static const int	  Frames	= 20;
+
+// World matrix of node from its chain of local transforms, the slow way
+static glm::mat4 ReferenceWorld(const SceneGraph& graph, NodeID node)
+{
+    glm::mat4 world(1.0f);
+    for (NodeID n = node; n != InvalidNode; n = graph.GetParent(n))
+    {
+        glm::mat4 local = glm::translate(glm::mat4(1.0f), graph.GetPosition(n)) * glm::mat4_cast(graph.GetRotation(n)) * glm::scale(glm::mat4(1.0f), graph.GetScale(n));
+        world = local * world;
+    }
+    return world;
+}
+
+// Moves fraction of the nodes every frame, like objects animating, and times the Update that follows
+static void BenchMoving(SceneGraph& graph, const std::vector<NodeID>& nodes, float fraction, unsigned int threads)
+{
+    std::mt19937 random(12345);
+    std::uniform_int_distribution<uint32_t> pick(0, (uint32_t)nodes.size() - 1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    uint32_t moving = (uint32_t)(nodes.size() * fraction);
+
+    double best = DBL_MAX, total = 0.0;
+    for (int frame = 0; frame < Frames; frame++)
+    {
+        for (uint32_t i = 0; i < moving; i++)
+            graph.SetPosition(nodes[pick(random)], glm::vec3(unit(random), unit(random), unit(random)));
+
+        double ms = TimeBest(1, [&]() { graph.Update(threads); });
+        best = std::min(best, ms);
+        total += ms;
+    }
+
+    //every node's world matrix against its chain multiplied out, on a sample
+    float error = 0.0f;
+    for (size_t i = 0; i < nodes.size(); i += 997)
+    {
+        glm::mat4 expected = ReferenceWorld(graph, nodes[i]);
+        const glm::mat4& world = graph.GetWorld(nodes[i]);
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 4; r++)
+                error = std::max(error, std::abs(world[c][r] - expected[c][r]));
+    }
+
+    std::printf("  %5.1f%% moving, %s: %7.3f ms best %7.3f ms average, max error %.2e\n", fraction * 100.0f,
+                threads == 1 ? "1 thread   " : "all threads", best, total / Frames, error);
+}
+
+void RunSceneGraphBench()
+{
+    std::cout << "[Bench] Scene graph Update, " << NodeCount << " nodes in trees of " << GroupSize << ", " << Frames << " frames" << std::endl;
+
+    //every tree's nodes get a random earlier node of the same tree as parent, so depths and fan outs vary
+    SceneGraph graph;
+    std::vector<NodeID> nodes;
+    nodes.reserve(NodeCount);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (uint32_t i = 0; i < NodeCount; i++)
+    {
+        uint32_t inGroup = i % GroupSize;
+        NodeID parent = inGroup == 0 ? InvalidNode : nodes[i - 1 - random() % inGroup];
+        NodeID node = graph.Create(parent);
+        graph.SetRotation(node, glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random))));
+        graph.SetScale(node, glm::vec3(0.9f));
+        nodes.push_back(node);
+    }
+    double first = TimeBest(1, [&]() { graph.Update(); });
+    std::printf("  first Update, ordering and every node: %.3f ms\n", first);
+
+    static const float fractions[] = { 0.001f, 0.01f, 0.1f };
+    for (float fraction : fractions)
+    {
+        BenchMoving(graph, nodes, fraction, 1);
+        BenchMoving(graph, nodes, fraction, 0);
+    }
+}
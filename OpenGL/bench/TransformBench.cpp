@@ -0,0 +1,125 @@
+#include "Bench.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../src/TransformKernels.h"
+#include "../src/CpuFeatures.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+static const int Runs = 5;
+
+// Largest difference to the glm result, relative to the element for elements above 1
+static double MaxError(const std::vector<glm::mat4>& expected, const std::vector<unsigned char>& out, unsigned int stride)
+{
+    double worst = 0.0;
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        glm::mat4 m;
+        std::memcpy(&m, &out[i * stride], sizeof(glm::mat4));
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 4; r++)
+            {
+                double reference = expected[i][c][r];
+                worst = std::max(worst, std::abs(m[c][r] - reference) / std::max(1.0, std::abs(reference)));
+            }
+    }
+    return worst;
+}
+
+// Runs kernel at every SIMD level into packed and strided output, against a glm loop writing the same output.
+// reference(i) is the glm result for object i.
+template<typename Reference, typename Kernel>
+static void BenchKernel(const char* name, uint32_t count, Reference reference, Kernel kernel)
+{
+    static const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 };
+    static const char* names[] = { "scalar", "sse2", "avx2" };
+    //packed, and one matrix per 256 bytes like ObjectBlocks in a UniformRingBuffer with the usual offset alignment
+    static const unsigned int strides[] = { sizeof(glm::mat4), 256 };
+
+    std::vector<glm::mat4> expected(count);
+    for (uint32_t i = 0; i < count; i++)
+        expected[i] = reference(i);
+
+    std::printf(" %s, %u objects\n", name, count);
+    std::vector<unsigned char> out;
+    for (unsigned int stride : strides)
+    {
+        out.assign((size_t)count * stride, 0);
+        double glmMs = TimeBest(Runs, [&]()
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                glm::mat4 m = reference(i);
+                std::memcpy(&out[(size_t)i * stride], &m, sizeof(glm::mat4));
+            }
+        });
+        std::printf("  %-6s %3u B %9.3f ms %8.1f M/s\n", "glm", stride, glmMs, count / glmMs / 1000.0);
+
+        for (int l = 0; l < 3; l++)
+        {
+            CpuFeatures::SetSimdLevel(levels[l]);
+            if (CpuFeatures::GetSimdLevel() != levels[l])
+            {
+                std::printf("  %-6s %3u B  not supported\n", names[l], stride);
+                continue;
+            }
+            double ms = TimeBest(Runs, [&]() { kernel(out.data(), stride); });
+            std::printf("  %-6s %3u B %9.3f ms %8.1f M/s %6.2fx  max error %.2e\n", names[l], stride, ms, count / ms / 1000.0,
+                        glmMs / ms, MaxError(expected, out, stride));
+        }
+    }
+    CpuFeatures::SetSimdLevel(SimdLevel::AVX2);
+}
+
+void RunTransformBench()
+{
+    std::cout << "[Bench] Transform kernels, best of " << Runs << ", speedup over glm writing the same stride" << std::endl;
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1500.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 50.0f, 600.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 viewProjection = projection * view;
+
+    //one that stays in cache, one that doesn't
+    static const uint32_t counts[] = { 10000, 1000000 };
+    for (uint32_t count : counts)
+    {
+        std::mt19937 random(count);
+        std::uniform_real_distribution<float> position(-500.0f, 500.0f), unit(-1.0f, 1.0f), size(0.5f, 2.0f);
+
+        std::vector<glm::vec3> positions(count), scales(count);
+        std::vector<glm::quat> rotations(count);
+        std::vector<glm::mat4> models(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            positions[i] = glm::vec3(position(random), position(random), position(random));
+            rotations[i] = glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random)));
+            scales[i]    = glm::vec3(size(random), size(random), size(random));
+        }
+
+        auto trs = [&](uint32_t i)
+        {
+            return glm::translate(glm::mat4(1.0f), positions[i]) * glm::mat4_cast(rotations[i]) * glm::scale(glm::mat4(1.0f), scales[i]);
+        };
+        for (uint32_t i = 0; i < count; i++)
+            models[i] = trs(i);
+
+        BenchKernel("ComposeTRS", count, trs, [&](unsigned char* out, unsigned int stride)
+        {
+            TransformKernels::ComposeTRS(positions.data(), rotations.data(), scales.data(), count, out, stride);
+        });
+        BenchKernel("Multiply", count, [&](uint32_t i) { return viewProjection * models[i]; }, [&](unsigned char* out, unsigned int stride)
+        {
+            TransformKernels::Multiply(viewProjection, models.data(), count, out, stride);
+        });
+        BenchKernel("ComposeMVP", count, [&](uint32_t i) { return viewProjection * trs(i); }, [&](unsigned char* out, unsigned int stride)
+        {
+            TransformKernels::ComposeMVP(viewProjection, positions.data(), rotations.data(), scales.data(), count, out, stride);
+        });
+    }
+}
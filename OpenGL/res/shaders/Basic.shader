@@ -6,12 +6,12 @@ layout(location=1) in vec2 texCoord;
 
 out vec2 v_TexCoord;
 
-uniform mat4 u_MVP;
+#include "Common.glsl"
 
 void main()
 {
 	v_TexCoord = texCoord;
-	gl_Position = u_MVP * position;
+	gl_Position = u_ViewProjection * u_Model * position;
 };
 
 #shader fragment
@@ -21,12 +21,19 @@ layout(location=0) out vec4 color;
 
 in vec2 v_TexCoord;
 
-uniform vec4 u_Color;
+#include "Common.glsl"
+
+// per material instance, see Material.h
+layout(std140) uniform Material
+{
+	vec4 u_Tint;
+};
+
 uniform sampler2D u_Texture;
 
 void main()
 {
-	vec4 texColor = texture(u_Texture, v_TexCoord);
+	vec4 texColor = texture(u_Texture, v_TexCoord) * u_Tint;
 	if (texColor.a > 0.0f)
 		color = texColor;
 	else
@@ -0,0 +1,48 @@
+#shader vertex
+#version 400 core
+
+layout(location=0) in vec4 position;
+layout(location=1) in vec2 texCoord;
+
+out vec2 v_TexCoord;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+	v_TexCoord = texCoord;
+	gl_Position = u_MVP * position;
+};
+
+#shader fragment
+#version 400 core
+#extension GL_ARB_bindless_texture : require
+
+// BindlessTextureTable::GetShaderDefines sets it to the table's capacity
+#ifndef TEXTURE_TABLE_CAPACITY
+#define TEXTURE_TABLE_CAPACITY 256
+#endif
+
+layout(location=0) out vec4 color;
+
+in vec2 v_TexCoord;
+
+// filled by BindlessTextureTable, one handle per uvec4 because of std140 padding.
+// Connect it to the binding point passed to BindlessTextureTable::Bind with Shader::SetUniformBlockBinding
+layout(std140) uniform TextureHandles
+{
+	uvec4 u_TextureHandles[TEXTURE_TABLE_CAPACITY];
+};
+
+uniform vec4 u_Color;
+uniform int u_TextureIndex;
+
+void main()
+{
+	sampler2D tex = sampler2D(u_TextureHandles[u_TextureIndex].xy);
+	vec4 texColor = texture(tex, v_TexCoord);
+	if (texColor.a > 0.0f)
+		color = texColor;
+	else
+		color = u_Color;
+};
\ No newline at end of file
@@ -0,0 +1,37 @@
+#shader vertex
+#version 330 core
+
+layout(location=0) in vec4 position;
+layout(location=1) in vec2 texCoord;
+
+out vec2 v_TexCoord;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+	v_TexCoord = texCoord;
+	gl_Position = u_MVP * position;
+};
+
+#shader fragment
+#version 330 core
+
+layout(location=0) out vec4 color;
+
+in vec2 v_TexCoord;
+
+// same interface as Bindless.shader, but the entry is bound with BindlessTextureTable::Bind(index, slot)
+// and u_TextureIndex is ignored
+uniform vec4 u_Color;
+uniform int u_TextureIndex;
+uniform sampler2D u_Texture;
+
+void main()
+{
+	vec4 texColor = texture(u_Texture, v_TexCoord);
+	if (texColor.a > 0.0f)
+		color = texColor;
+	else
+		color = u_Color;
+};
@@ -0,0 +1,16 @@
+// Uniform blocks shared by all programs, see UniformBuffer.h for the matching structs
+
+// updated once per frame
+layout(std140) uniform Camera
+{
+	mat4 u_ViewProjection;
+	mat4 u_View;
+	mat4 u_Projection;
+};
+
+// per draw, a range of the object ring buffer
+layout(std140) uniform Object
+{
+	mat4 u_Model;
+	vec4 u_Color;
+};
\ No newline at end of file
@@ -0,0 +1,51 @@
+#shader compute
+#version 430 core
+
+layout(local_size_x = 64) in;
+
+#include "Culling.glsl"
+
+struct DrawCommand
+{
+	uint Count;
+	uint InstanceCount;
+	uint FirstIndex;
+	int BaseVertex;
+	uint BaseInstance;
+};
+
+layout(std430, binding = 1) writeonly buffer DrawCommands
+{
+	DrawCommand commands[];
+};
+
+layout(std430, binding = 2) buffer DrawCount
+{
+	uint drawCount;
+};
+
+layout(std140) uniform Culling
+{
+	vec4 u_Planes[6];
+	uint u_ObjectCount;
+};
+
+// one object per invocation, visible ones are appended in no particular order. Keep in sync with GPUCulling::CullReference
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= u_ObjectCount)
+		return;
+
+	CullObject object = objects[i];
+	vec3 center = (object.Model * vec4(object.Sphere.xyz, 1.0)).xyz;
+	float scale = max(length(object.Model[0].xyz), max(length(object.Model[1].xyz), length(object.Model[2].xyz)));
+	float radius = object.Sphere.w * scale;
+
+	for (int p = 0; p < 6; p++)
+		if (dot(u_Planes[p].xyz, center) + u_Planes[p].w < -radius)
+			return;
+
+	uint slot = atomicAdd(drawCount, 1u);
+	commands[slot] = DrawCommand(object.IndexCount, 1u, object.FirstIndex, object.BaseVertex, i);
+};
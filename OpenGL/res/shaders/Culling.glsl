@@ -0,0 +1,16 @@
+// Objects of GPUCulling, see GPUCulling.h for the matching structs
+
+struct CullObject
+{
+	mat4 Model;
+	vec4 Sphere; // local center and radius
+	uint IndexCount;
+	uint FirstIndex;
+	int BaseVertex;
+	uint Padding;
+};
+
+layout(std430, binding = 0) readonly buffer CullObjects
+{
+	CullObject objects[];
+};
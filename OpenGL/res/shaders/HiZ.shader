@@ -0,0 +1,36 @@
+#shader vertex
+#version 330 core
+
+// one triangle covering the viewport, no vertex buffer needed
+void main()
+{
+	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+};
+
+#shader fragment
+#version 330 core
+
+layout(location=0) out float depth;
+
+uniform sampler2D u_Source; // the depth buffer or the previous pyramid level, as its only visible level
+uniform int u_SourceWidth;
+uniform int u_SourceHeight;
+
+// farthest depth under this texel. The last row and column of an odd sized source also take the texel
+// that would be dropped, same as the CPU levels in HiZBuffer.cpp
+void main()
+{
+	ivec2 size = ivec2(max(u_SourceWidth / 2, 1), max(u_SourceHeight / 2, 1));
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	ivec2 first = texel * 2;
+	ivec2 last = min(ivec2(texel.x == size.x - 1 ? u_SourceWidth - 1 : first.x + 1,
+						   texel.y == size.y - 1 ? u_SourceHeight - 1 : first.y + 1),
+					 ivec2(u_SourceWidth - 1, u_SourceHeight - 1));
+
+	float farthest = 0.0;
+	for (int y = first.y; y <= last.y; y++)
+		for (int x = first.x; x <= last.x; x++)
+			farthest = max(farthest, texelFetch(u_Source, ivec2(x, y), 0).r);
+	depth = farthest;
+};
@@ -0,0 +1,31 @@
+#shader vertex
+#version 430 core
+
+layout(location=0) in vec4 position;
+layout(location=1) in vec2 texCoord;
+layout(location=7) in uint objectID; // GPUCulling::AttachObjectIDs
+
+out vec2 v_TexCoord;
+
+#include "Common.glsl"
+#include "Culling.glsl"
+
+void main()
+{
+	v_TexCoord = texCoord;
+	gl_Position = u_ViewProjection * objects[objectID].Model * position;
+};
+
+#shader fragment
+#version 430 core
+
+layout(location=0) out vec4 color;
+
+in vec2 v_TexCoord;
+
+uniform sampler2D u_Texture;
+
+void main()
+{
+	color = texture(u_Texture, v_TexCoord);
+};
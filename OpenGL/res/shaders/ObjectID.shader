@@ -0,0 +1,24 @@
+#shader vertex
+#version 330 core
+
+layout(location=0) in vec4 position;
+
+#include "Common.glsl"
+
+void main()
+{
+	gl_Position = u_ViewProjection * u_Model * position;
+};
+
+#shader fragment
+#version 330 core
+
+layout(location=0) out uint id;
+
+// object id + 1, 0 is left where nothing was drawn
+uniform int u_ObjectID;
+
+void main()
+{
+	id = uint(u_ObjectID);
+};
@@ -0,0 +1,35 @@
+#shader vertex
+#version 330 core
+
+layout(location=0) in vec4 position;
+layout(location=1) in vec2 texCoord;
+
+out vec2 v_TexCoord;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+	v_TexCoord = texCoord;
+	gl_Position = u_MVP * position;
+};
+
+#shader fragment
+#version 330 core
+
+layout(location=0) out vec4 color;
+
+in vec2 v_TexCoord;
+
+uniform vec4 u_Color;
+uniform sampler2DArray u_Textures;
+uniform int u_Layer;
+
+void main()
+{
+	vec4 texColor = texture(u_Textures, vec3(v_TexCoord, u_Layer));
+	if (texColor.a > 0.0f)
+		color = texColor;
+	else
+		color = u_Color;
+};
\ No newline at end of file
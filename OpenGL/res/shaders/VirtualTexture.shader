@@ -0,0 +1,44 @@
+#shader vertex
+#version 330 core
+
+layout(location=0) in vec4 position;
+layout(location=1) in vec2 texCoord;
+
+out vec2 v_TexCoord;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+	v_TexCoord = texCoord;
+	gl_Position = u_MVP * position;
+};
+
+#shader fragment
+#version 330 core
+
+layout(location=0) out vec4 color;
+
+in vec2 v_TexCoord;
+
+uniform sampler2D u_PageTable;
+uniform sampler2D u_Cache;
+uniform vec4 u_VTParams; // tiles per side, max mip, cache slots per side, tile size
+uniform vec4 u_VTScale;	 // image uv -> virtual uv (xy), tile border, feedback mip bias
+
+void main()
+{
+	vec2 uv = v_TexCoord * u_VTScale.xy;
+
+	vec2 texel = uv * u_VTParams.x * u_VTParams.w;
+	float mip = clamp(log2(max(length(dFdx(texel)), length(dFdy(texel)))), 0.0, u_VTParams.y);
+
+	// the entry points at the finest resident tile covering this pixel, which may be coarser than requested
+	vec4 entry = textureLod(u_PageTable, uv, floor(mip)) * 255.0;
+	float tiles = u_VTParams.x / exp2(entry.b);
+	vec2 inTile = fract(uv * tiles);
+
+	float slotSize = u_VTParams.w + 2.0 * u_VTScale.z;
+	vec2 cacheTexel = entry.rg * slotSize + u_VTScale.z + inTile * u_VTParams.w;
+	color = textureLod(u_Cache, cacheTexel / (u_VTParams.z * slotSize), 0.0);
+};
\ No newline at end of file
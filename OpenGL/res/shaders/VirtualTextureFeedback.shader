@@ -0,0 +1,38 @@
+#shader vertex
+#version 330 core
+
+layout(location=0) in vec4 position;
+layout(location=1) in vec2 texCoord;
+
+out vec2 v_TexCoord;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+	v_TexCoord = texCoord;
+	gl_Position = u_MVP * position;
+};
+
+#shader fragment
+#version 330 core
+
+layout(location=0) out vec4 color;
+
+in vec2 v_TexCoord;
+
+uniform vec4 u_VTParams; // tiles per side, max mip, cache slots per side, tile size
+uniform vec4 u_VTScale;	 // image uv -> virtual uv (xy), tile border, feedback mip bias
+
+// writes the tile (x, y, mip) this pixel needs, read back by VirtualTexture::EndFeedback
+void main()
+{
+	vec2 uv = clamp(v_TexCoord * u_VTScale.xy, 0.0, 1.0);
+
+	vec2 texel = uv * u_VTParams.x * u_VTParams.w;
+	float mip = floor(clamp(log2(max(length(dFdx(texel)), length(dFdy(texel)))) - u_VTScale.w, 0.0, u_VTParams.y));
+
+	float tiles = u_VTParams.x / exp2(mip);
+	vec2 tile = min(floor(uv * tiles), tiles - 1.0);
+	color = vec4(tile, mip, 255.0) / 255.0;
+};
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <algorithm>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -13,6 +14,22 @@
 #include "VertexArray.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "ShaderHotReload.h"
+#include "UniformBuffer.h"
+#include "UniformRingBuffer.h"
+#include "Material.h"
+#include "MaterialInstance.h"
+#include "SceneGraph.h"
+#include "FrustumCulling.h"
+#include "BVH.h"
+#include "HiZBuffer.h"
+#include "Camera.h"
+#include "EntityWorld.h"
+#include "RenderExtraction.h"
+#include "ObjectPicker.h"
+
+#include "../tests/Tests.h"
+#include "../bench/Bench.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -23,8 +40,15 @@
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
 
-int main(void)
+// -test runs the checks in tests/, -bench <name|all> the benchmarks in bench/, instead of the application
+int main(int argc, char** argv)
 {
+    bool runTests = argc > 1 && std::string(argv[1]) == "-test";
+
+    //the benchmarks are CPU only, no window needed
+    if (argc > 1 && std::string(argv[1]) == "-bench")
+        return RunBenchmarks(argc > 2 ? argv[2] : "all") ? 0 : 1;
+
     GLFWwindow* window;
 
     /* Initialize the library */
@@ -37,6 +61,10 @@ int main(void)
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 
+    //the tests only need the context
+    if (runTests)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
     /* Create a windowed mode window and its OpenGL context */
     window = glfwCreateWindow(640, 480, "OpenGl", NULL, NULL);
     if (!window)
@@ -56,6 +84,13 @@ int main(void)
 
     std::cout << glGetString(GL_VERSION) << std::endl;
 
+    if (runTests)
+    {
+        int failures = RunUniformAllocationTest();
+        glfwTerminate();
+        return failures;
+    }
+
     { //Scope to force delete of stack allocated buffers
     //Triangle x1, y1, x2, y2, x3, y3
         float positions[] = {
@@ -76,26 +111,41 @@ int main(void)
         VertexBuffer vb(positions, 4 * 4 * sizeof(float)); // 4 points of 4 coords (2 position + 2 texture uv)
 
         VertexBufferLayout layout;
-        layout.Push<float>(2);
-        layout.Push<float>(2);
+        layout.Push<float>(2, "position");
+        layout.Push<float>(2, "texCoord");
         
         VertexArray va;
         va.AddBuffer(vb, layout);
 
         IndexBuffer ib(indices, 6);
 
-        glm::mat4 proj  = glm::ortho(0.0f, 960.0f, 0.5f, 540.0f, -1.0f, 1.0f); 
-        glm::mat4 view  = glm::translate(glm::mat4(1.0f), glm::vec3(-100, 0, 0));
+        OrthographicCamera camera(0.0f, 960.0f, 0.5f, 540.0f, -1.0f, 1.0f);
+        glm::vec3 cameraPosition(100.0f, 0.0f, 0.0f);
+        camera.SetPosition(cameraPosition);
+
+        //The camera block is only uploaded again when the camera changed, see Camera::GetVersion
+        UniformBuffer cameraBuffer(sizeof(CameraBlock));
+        cameraBuffer.BindBase(UniformBinding::Camera);
+        uint32_t cameraVersion = camera.GetVersion() - 1;
+
+        //Per object blocks, a new range every frame
+        UniformRingBuffer objectBuffer(64 * 1024);
 
         Shader shader("res/shaders/Basic.shader");
         shader.Bind();
-        shader.SetUniform4f("u_Color", 0.8f, 0.3f, 0.8f, 1.0f);
 
         Texture texture("res/textures/dickbutt.png");
-        texture.Bind();
 
-        //Tell our shader wich texture slot to sample from (same slot as passed to texture Bind)
-        shader.SetUniform1i("u_Texture", 0);
+        //The material owns which texture goes to wich sampler, instances override parameters per object
+        Material material(shader);
+        material.AddParameter("u_Tint", glm::vec4(1.0f));
+        material.AddTexture("u_Texture", &texture);
+
+        MaterialInstance instance(material);
+
+        //Edits to the shader file get picked up without restarting
+        ShaderHotReload hotReload;
+        hotReload.Add(shader);
 
         //Unbind everything
         va.Unbind();
@@ -105,6 +155,7 @@ int main(void)
 
         Renderer renderer;
         renderer.SetClearColor(0.13f, 0.13f, 0.13f, 1.0f);
+        renderer.SetObjectBuffer(&objectBuffer);
 
         ImGui::CreateContext();
         ImGuiIO& io = ImGui::GetIO(); (void)io;
@@ -129,25 +180,89 @@ int main(void)
 
         glm::vec3 translation(200, 200, 0);
 
+        SceneGraph scene;
+        NodeID quad = scene.Create();
+
+        //renderables live in the entity world, the extraction culls them and feeds the renderer
+        //the bounding sphere is around the quad's vertices (100..200 in x and y)
+        EntityWorld world;
+        Entity quadEntity = world.Create(TransformComponent{ translation, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f) },
+                                         MeshComponent{ &va, &ib, nullptr, 0 }, MaterialComponent{ &instance, glm::vec4(1.0f) },
+                                         BoundsComponent{ glm::vec3(150.0f, 150.0f, 0.0f), 71.0f }, VisibilityComponent{ false, false });
+        RenderExtraction extraction;
+
+        //exact picking on click, the id under the cursor comes back a frame or two later
+        ObjectPicker picker;
+        extraction.SetPicker(&picker);
+        uint32_t pickedEntity = NoObject;
+
+        //spatial index for picking with the mouse, refit every frame since the quad moves
+        BVH bvh;
+        bvh.Build({ { glm::vec3(100.0f, 100.0f, 0.0f), glm::vec3(200.0f, 200.0f, 0.0f) } });
+
+        //occlusion culling against last frame's depth
+        HiZBuffer hiZ;
+        bool showHiZ = false;
+        int hiZLevel = 0;
+
         /* Loop until the user closes the window */
         while (!glfwWindowShouldClose(window))
         {
             renderer.Clear();
+            //the overlay shows this frame's uniform traffic, not totals since startup
+            shader.ResetUniformStats();
+
+            hotReload.Update();
 
             // Start the Dear ImGui frame
             ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplGlfw_NewFrame();
             ImGui::NewFrame();
 
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), translation);
+            objectBuffer.BeginFrame();
 
-            glm::mat4 mvp = proj * view * model; // opengl matrix multiplication is right to left
+            int fbWidth, fbHeight;
+            glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+            camera.SetViewportSize((float)fbWidth, (float)fbHeight);
+            camera.SetPosition(cameraPosition);
+            if (camera.GetVersion() != cameraVersion)
+            {
+                CameraBlock block = { camera.GetViewProjection(), camera.GetView(), camera.GetProjection() };
+                cameraBuffer.SetData(&block, sizeof(CameraBlock));
+                cameraVersion = camera.GetVersion();
+            }
+
+            //only recomputes when the slider actually moved the node
+            if (translation != scene.GetPosition(quad))
+                scene.SetPosition(quad, translation);
+            scene.Update();
 
-            shader.Bind();
-            shader.SetUniform4f("u_Color", r, 0.3f, 0.8f, 1.0f);
-            shader.SetUniformMat4f("u_MVP", mvp);
+            glm::mat4 model = scene.GetWorld(quad);
+            world.Get<TransformComponent>(quadEntity)->Position = glm::vec3(model[3]);
+            world.Get<MaterialComponent>(quadEntity)->Color = glm::vec4(r, 0.3f, 0.8f, 1.0f);
 
-            renderer.Draw(va, ib, shader);
+            BoundingBox box = { glm::vec3(model * glm::vec4(100.0f, 100.0f, 0.0f, 1.0f)), glm::vec3(model * glm::vec4(200.0f, 200.0f, 0.0f, 1.0f)) };
+            bvh.SetBounds(0, box);
+            bvh.Refit();
+
+            if (ImGui::IsMouseClicked(0) && !io.WantCaptureMouse)
+            {
+                int windowWidth, windowHeight;
+                glfwGetWindowSize(window, &windowWidth, &windowHeight);
+                picker.RequestPick((int)(io.MousePos.x * fbWidth / std::max(windowWidth, 1)), (int)(io.MousePos.y * fbHeight / std::max(windowHeight, 1)));
+            }
+
+            //the shader multiplies u_ViewProjection * u_Model (opengl matrix multiplication is right to left)
+            hiZ.BeginTests(camera.GetUnjitteredViewProjection());
+            extraction.Extract(world, camera, objectBuffer, renderer, &hiZ);
+            objectBuffer.Flush();
+            renderer.Flush();
+            picker.Render(fbWidth, fbHeight, objectBuffer);
+            picker.Poll(pickedEntity);
+
+            hiZ.Build(fbWidth, fbHeight, camera.GetUnjitteredViewProjection());
+
+            objectBuffer.EndFrame();
 
             if (r > 1.0f)
                 increment = -0.05f;
@@ -165,9 +280,47 @@ int main(void)
                 ImGui::SliderFloat("X", &translation.x, 0.0f, 960.0f);
                 ImGui::SliderFloat("Y", &translation.y, 0.5f, 540.0f);
                 ImGui::SliderFloat("Z", &translation.z, -1.0f, 1.0f);
+                ImGui::SliderFloat("Camera X", &cameraPosition.x, 0.0f, 960.0f);
                 //ImGui::ColorEdit3("clear color", (float*)&clear_color); // Edit 3 floats representing a colo
 
                 ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+
+                int width, height;
+                glfwGetWindowSize(window, &width, &height);
+                Ray ray = Ray::FromScreen(glm::vec2(ImGui::GetIO().MousePos.x, ImGui::GetIO().MousePos.y), glm::vec2(width, height), camera.GetUnjitteredViewProjection());
+                RayHit hit;
+                if (bvh.Raycast(ray, hit))
+                    ImGui::Text("Mouse over object %u", hit.Object);
+                else
+                    ImGui::Text("Mouse over nothing");
+                if (pickedEntity != NoObject)
+                    ImGui::Text("Clicked entity %u", pickedEntity);
+                else
+                    ImGui::Text("Clicked nothing");
+
+                const UniformStats& uniformStats = shader.GetUniformStats();
+                ImGui::Text("Uniform writes %u, elided %u, uploaded %u", uniformStats.Writes, uniformStats.Elided, uniformStats.Uploads);
+
+                const RendererStats& rendererStats = renderer.GetStats();
+                ImGui::Text("Draws %u, triangles %u, shader binds %u, material binds %u, instance binds %u", rendererStats.DrawCalls, rendererStats.Triangles, rendererStats.ShaderBinds, rendererStats.MaterialBinds, rendererStats.InstanceBinds);
+
+                const ExtractionStats& extractionStats = extraction.GetStats();
+                ImGui::Text("Entities %u, frustum culled %u, occlusion culled %u, submitted %u", extractionStats.Entities,
+                            extractionStats.FrustumCulled, extractionStats.OcclusionCulled, extractionStats.Submitted);
+
+                const OcclusionStats& occlusionStats = hiZ.GetStats();
+                ImGui::Text("Hi-Z %s, tested %u, occluded %u", hiZ.IsEnabled() ? "on" : "off", occlusionStats.Tested, occlusionStats.Occluded);
+                ImGui::Checkbox("Show Hi-Z", &showHiZ);
+                if (showHiZ && hiZ.GetLevelCount() > 0)
+                {
+                    hiZLevel = std::min(hiZLevel, hiZ.GetLevelCount() - 1);
+                    ImGui::SliderInt("Level", &hiZLevel, 0, hiZ.GetLevelCount() - 1);
+                    int levelWidth, levelHeight;
+                    unsigned int levelTexture = hiZ.GetDebugTexture(hiZLevel, levelWidth, levelHeight);
+                    //scaled up to a fixed width, flipped since GL rows start at the bottom
+                    float scale = 256.0f / levelWidth;
+                    ImGui::Image((ImTextureID)(intptr_t)levelTexture, ImVec2(256.0f, levelHeight * scale), ImVec2(0, 1), ImVec2(1, 0));
+                }
                 ImGui::End();
             }
 
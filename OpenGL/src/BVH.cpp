@@ -0,0 +1,675 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+static const uint32_t MaxLeafSize		= 4;
+static const uint32_t BinCount			= 16;
+// Subtrees smaller than this are built on the thread that reached them
+static const uint32_t ParallelThreshold = 8 * 1024;
+static const uint32_t InvalidObject		= 0xFFFFFFFF;
+
+static BoundingBox EmptyBox()
+{
+    return { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+}
+
+static void Grow(BoundingBox& box, const BoundingBox& other)
+{
+    box.Min = glm::min(box.Min, other.Min);
+    box.Max = glm::max(box.Max, other.Max);
+}
+
+static float HalfArea(const BoundingBox& box)
+{
+    glm::vec3 size = glm::max(box.Max - box.Min, glm::vec3(0.0f));
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+static void SetSlot(BVHNode& node, int slot, const BoundingBox& box)
+{
+    node.MinX[slot] = box.Min.x; node.MinY[slot] = box.Min.y; node.MinZ[slot] = box.Min.z;
+    node.MaxX[slot] = box.Max.x; node.MaxY[slot] = box.Max.y; node.MaxZ[slot] = box.Max.z;
+}
+
+static BoundingBox GetSlot(const BVHNode& node, int slot)
+{
+    return { glm::vec3(node.MinX[slot], node.MinY[slot], node.MinZ[slot]), glm::vec3(node.MaxX[slot], node.MaxY[slot], node.MaxZ[slot]) };
+}
+
+Ray Ray::FromScreen(const glm::vec2& pixel, const glm::vec2& viewport, const glm::mat4& viewProjection)
+{
+    glm::vec2 ndc(pixel.x / viewport.x * 2.0f - 1.0f, 1.0f - pixel.y / viewport.y * 2.0f);
+    glm::mat4 inverse = glm::inverse(viewProjection);
+
+    glm::vec4 nearPoint = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+    glm::vec4 farPoint	= inverse * glm::vec4(ndc,  1.0f, 1.0f);
+    nearPoint /= nearPoint.w;
+    farPoint  /= farPoint.w;
+
+    return { glm::vec3(nearPoint), glm::normalize(glm::vec3(farPoint - nearPoint)) };
+}
+
+BVH::BVH()
+    : m_BuiltCost(0.0f), m_BuildNodeCount(0)
+{
+}
+
+void BVH::Build(const std::vector<BoundingBox>& bounds, unsigned int threads)
+{
+    m_Bounds = bounds;
+    m_Nodes.clear();
+
+    uint32_t count = (uint32_t)bounds.size();
+    m_Objects.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+        m_Objects[i] = i;
+
+    if (count == 0)
+    {
+        m_BuiltCost = 0.0f;
+        m_BuiltNodeCosts.clear();
+        return;
+    }
+
+    BuildRange(0, count, threads);
+    ReleaseBuildData();
+
+    m_BuiltCost = GetCost();
+    m_BuiltNodeCosts.resize(m_Nodes.size());
+    for (size_t n = 0; n < m_Nodes.size(); n++)
+        m_BuiltNodeCosts[n] = NodeCost(m_Nodes[n]);
+}
+
+// Builds the objects in m_Objects[start, start + count) into m_Nodes, which must be empty, root first. The scratch
+// arrays stay allocated for the next range until ReleaseBuildData.
+void BVH::BuildRange(uint32_t start, uint32_t count, unsigned int threads)
+{
+    m_Centroids.resize(m_Bounds.size());
+    for (uint32_t i = start; i < start + count; i++)
+    {
+        const BoundingBox& box = m_Bounds[m_Objects[i]];
+        m_Centroids[m_Objects[i]] = (box.Min + box.Max) * 0.5f;
+    }
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    //a binary tree over n objects never has more than 2n - 1 nodes, so tasks can grab indices without locking
+    m_BuildNodes.resize(2 * count);
+    m_BuildNodeCount = 1;
+
+    //each level of parallel splits doubles the tasks, stop once there is one per thread
+    unsigned int parallelDepth = 0;
+    while ((1u << parallelDepth) < threads)
+        parallelDepth++;
+
+    BuildRecursive(0, start, count, 0, parallelDepth);
+
+    m_Nodes.reserve(count / 2 + 1);
+    Collapse(0);
+}
+
+void BVH::ReleaseBuildData()
+{
+    m_BuildNodes.clear();
+    m_BuildNodes.shrink_to_fit();
+    m_Centroids.clear();
+    m_Centroids.shrink_to_fit();
+}
+
+void BVH::BuildRecursive(uint32_t nodeIndex, uint32_t start, uint32_t count, unsigned int depth, unsigned int parallelDepth)
+{
+    BuildNode& node = m_BuildNodes[nodeIndex];
+
+    BoundingBox bounds = EmptyBox();
+    BoundingBox centroids = EmptyBox();
+    for (uint32_t i = start; i < start + count; i++)
+    {
+        Grow(bounds, m_Bounds[m_Objects[i]]);
+        centroids.Min = glm::min(centroids.Min, m_Centroids[m_Objects[i]]);
+        centroids.Max = glm::max(centroids.Max, m_Centroids[m_Objects[i]]);
+    }
+    node.Bounds = bounds;
+    node.Start	= start;
+    node.Count	= count;
+
+    if (count <= MaxLeafSize)
+        return;
+
+    glm::vec3 extent = centroids.Max - centroids.Min;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    uint32_t* first = m_Objects.data() + start;
+    uint32_t* last	= first + count;
+    uint32_t* middle;
+    if (extent[axis] <= 0.0f)
+    {
+        //all centroids in one spot, SAH cant tell them apart, halve the range
+        middle = first + count / 2;
+    }
+    else
+    {
+        //bin the centroids and pick the plane between bins with the lowest surface area cost
+        BoundingBox binBounds[BinCount];
+        uint32_t	binCounts[BinCount] = {};
+        for (uint32_t b = 0; b < BinCount; b++)
+            binBounds[b] = EmptyBox();
+
+        float scale = BinCount / extent[axis] * 0.9999f;
+        float origin = centroids.Min[axis];
+        auto binOf = [&](uint32_t object) { return std::min((uint32_t)((m_Centroids[object][axis] - origin) * scale), BinCount - 1); };
+
+        for (uint32_t* it = first; it != last; ++it)
+        {
+            uint32_t b = binOf(*it);
+            binCounts[b]++;
+            Grow(binBounds[b], m_Bounds[*it]);
+        }
+
+        float	 leftArea[BinCount - 1];
+        uint32_t leftCount[BinCount - 1];
+        BoundingBox box = EmptyBox();
+        uint32_t sum = 0;
+        for (uint32_t b = 0; b < BinCount - 1; b++)
+        {
+            Grow(box, binBounds[b]);
+            sum += binCounts[b];
+            leftArea[b]	 = HalfArea(box);
+            leftCount[b] = sum;
+        }
+
+        float bestCost = FLT_MAX;
+        uint32_t bestSplit = 0;
+        box = EmptyBox();
+        sum = 0;
+        for (uint32_t b = BinCount - 1; b > 0; b--)
+        {
+            Grow(box, binBounds[b]);
+            sum += binCounts[b];
+            float cost = leftArea[b - 1] * leftCount[b - 1] + HalfArea(box) * sum;
+            if (leftCount[b - 1] && sum && cost < bestCost)
+            {
+                bestCost  = cost;
+                bestSplit = b - 1;
+            }
+        }
+
+        //splitting only pays if it beats testing every object of a leaf, but leaves are kept small regardless
+        if (bestCost >= HalfArea(bounds) * count && count <= MaxLeafSize * 4)
+            return;
+
+        middle = std::partition(first, last, [&](uint32_t object) { return binOf(object) <= bestSplit; });
+        if (middle == first || middle == last)
+            middle = first + count / 2;
+    }
+
+    uint32_t left = m_BuildNodeCount.fetch_add(2);
+    node.Left  = left;
+    node.Right = left + 1;
+    node.Count = 0;
+
+    uint32_t leftCount = (uint32_t)(middle - first);
+    if (depth < parallelDepth && count > ParallelThreshold)
+    {
+        auto task = std::async(std::launch::async, [=]() { BuildRecursive(left, start, leftCount, depth + 1, parallelDepth); });
+        BuildRecursive(left + 1, start + leftCount, count - leftCount, depth + 1, parallelDepth);
+        task.wait();
+    }
+    else
+    {
+        BuildRecursive(left, start, leftCount, depth + 1, parallelDepth);
+        BuildRecursive(left + 1, start + leftCount, count - leftCount, depth + 1, parallelDepth);
+    }
+}
+
+// Pulls grandchildren up until the node has four children, always opening the largest one
+uint32_t BVH::Collapse(uint32_t buildNode)
+{
+    uint32_t nodeIndex = (uint32_t)m_Nodes.size();
+    m_Nodes.push_back(BVHNode());
+
+    uint32_t children[4];
+    int childCount = 0;
+    const BuildNode& root = m_BuildNodes[buildNode];
+    if (root.Count > 0)
+        children[childCount++] = buildNode;
+    else
+    {
+        children[childCount++] = root.Left;
+        children[childCount++] = root.Right;
+    }
+
+    while (childCount < 4)
+    {
+        int largest = -1;
+        float largestArea = -1.0f;
+        for (int c = 0; c < childCount; c++)
+        {
+            const BuildNode& child = m_BuildNodes[children[c]];
+            if (child.Count == 0 && HalfArea(child.Bounds) > largestArea)
+            {
+                largest = c;
+                largestArea = HalfArea(child.Bounds);
+            }
+        }
+        if (largest == -1)
+            break;
+
+        const BuildNode& opened = m_BuildNodes[children[largest]];
+        children[largest] = opened.Left;
+        children[childCount++] = opened.Right;
+    }
+
+    for (int slot = 0; slot < 4; slot++)
+    {
+        //m_Nodes grows while collapsing the children, so the node is looked up again every time
+        if (slot >= childCount)
+        {
+            SetSlot(m_Nodes[nodeIndex], slot, EmptyBox());
+            m_Nodes[nodeIndex].Child[slot] = -1;
+            m_Nodes[nodeIndex].Count[slot] = 0;
+            continue;
+        }
+
+        const BuildNode& child = m_BuildNodes[children[slot]];
+        int32_t target = child.Count > 0 ? (int32_t)child.Start : (int32_t)Collapse(children[slot]);
+
+        BVHNode& node = m_Nodes[nodeIndex];
+        SetSlot(node, slot, child.Bounds);
+        node.Child[slot] = target;
+        node.Count[slot] = child.Count;
+    }
+
+    return nodeIndex;
+}
+
+void BVH::SetBounds(uint32_t object, const BoundingBox& bounds)
+{
+    m_Bounds[object] = bounds;
+}
+
+void BVH::Refit()
+{
+    //children always come after their parent, walking backwards refits them first
+    for (size_t n = m_Nodes.size(); n-- > 0;)
+    {
+        BVHNode& node = m_Nodes[n];
+        for (int slot = 0; slot < 4; slot++)
+        {
+            if (node.Child[slot] < 0)
+                continue;
+
+            BoundingBox box = EmptyBox();
+            if (node.Count[slot] > 0)
+            {
+                for (uint32_t i = 0; i < node.Count[slot]; i++)
+                    Grow(box, m_Bounds[m_Objects[node.Child[slot] + i]]);
+            }
+            else
+            {
+                const BVHNode& child = m_Nodes[node.Child[slot]];
+                for (int c = 0; c < 4; c++)
+                    if (child.Child[c] >= 0)
+                        Grow(box, GetSlot(child, c));
+            }
+            SetSlot(node, slot, box);
+        }
+    }
+}
+
+bool BVH::Optimize(float maxDegradation)
+{
+    Refit();
+    if (m_Nodes.empty())
+        return false;
+
+    //topmost nodes whose own slots grew past the threshold. Rebuilding below a node can't shrink its slots, they
+    //bound the same objects either way, so a degraded node is rebuilt whole and nothing under it is looked at.
+    std::vector<uint32_t> roots;
+    std::vector<uint32_t> stack(1, 0);
+    while (!stack.empty())
+    {
+        uint32_t n = stack.back();
+        stack.pop_back();
+        if (NodeCost(m_Nodes[n]) > m_BuiltNodeCosts[n] * maxDegradation)
+        {
+            roots.push_back(n);
+            continue;
+        }
+        for (int slot = 0; slot < 4; slot++)
+            if (m_Nodes[n].Child[slot] >= 0 && m_Nodes[n].Count[slot] == 0)
+                stack.push_back(m_Nodes[n].Child[slot]);
+    }
+
+    //the root itself went bad, or the damage is spread too thin for any node to pass the threshold on its own
+    bool full = roots.empty() ? GetCost() > m_BuiltCost * maxDegradation : roots[0] == 0;
+    if (full)
+    {
+        std::vector<BoundingBox> bounds;
+        bounds.swap(m_Bounds);
+        Build(bounds);
+        return true;
+    }
+    if (roots.empty())
+        return false;
+
+    std::sort(roots.begin(), roots.end());
+    RebuildSubtrees(roots);
+    return true;
+}
+
+// Collapse emits nodes depth first, so every subtree is a contiguous run of nodes and, since the build partitions
+// in place, of m_Objects too. Each root's run is replaced by a fresh build of the same objects and the other nodes
+// are copied over with their child indices moved.
+void BVH::RebuildSubtrees(const std::vector<uint32_t>& roots)
+{
+    std::vector<BVHNode> old;
+    old.swap(m_Nodes);
+
+    std::vector<BVHNode> nodes;
+    std::vector<float>	 costs;
+    std::vector<uint8_t> rebuilt;
+    std::vector<int32_t> remap(old.size(), -1);
+    nodes.reserve(old.size());
+    costs.reserve(old.size());
+    rebuilt.reserve(old.size());
+
+    std::vector<uint32_t> stack;
+    size_t next = 0;
+    for (uint32_t n = 0; n < (uint32_t)old.size();)
+    {
+        if (next == roots.size() || roots[next] != n)
+        {
+            remap[n] = (int32_t)nodes.size();
+            nodes.push_back(old[n]);
+            costs.push_back(m_BuiltNodeCosts[n]);
+            rebuilt.push_back(0);
+            n++;
+            continue;
+        }
+        next++;
+
+        uint32_t subtreeNodes = 0, start = 0xFFFFFFFF, count = 0;
+        stack.assign(1, n);
+        while (!stack.empty())
+        {
+            const BVHNode& node = old[stack.back()];
+            stack.pop_back();
+            subtreeNodes++;
+            for (int slot = 0; slot < 4; slot++)
+            {
+                if (node.Child[slot] < 0)
+                    continue;
+                if (node.Count[slot] > 0)
+                {
+                    start = std::min(start, (uint32_t)node.Child[slot]);
+                    count += node.Count[slot];
+                }
+                else
+                    stack.push_back(node.Child[slot]);
+            }
+        }
+
+        BuildRange(start, count, 0);
+
+        int32_t base = (int32_t)nodes.size();
+        remap[n] = base;
+        for (BVHNode& node : m_Nodes)
+        {
+            for (int slot = 0; slot < 4; slot++)
+                if (node.Child[slot] >= 0 && node.Count[slot] == 0)
+                    node.Child[slot] += base;
+            nodes.push_back(node);
+            costs.push_back(NodeCost(node));
+            rebuilt.push_back(1);
+        }
+        m_Nodes.clear();
+        n += subtreeNodes;
+    }
+
+    for (size_t n = 0; n < nodes.size(); n++)
+    {
+        if (rebuilt[n])
+            continue;
+        for (int slot = 0; slot < 4; slot++)
+            if (nodes[n].Child[slot] >= 0 && nodes[n].Count[slot] == 0)
+                nodes[n].Child[slot] = remap[nodes[n].Child[slot]];
+    }
+
+    ReleaseBuildData();
+    m_Nodes.swap(nodes);
+    m_BuiltNodeCosts.swap(costs);
+}
+
+// A node's own term of the SAH cost, unnormalized: its slots' areas, leaves weighted by their object count
+float BVH::NodeCost(const BVHNode& node)
+{
+    float cost = 0.0f;
+    for (int slot = 0; slot < 4; slot++)
+        if (node.Child[slot] >= 0)
+            cost += HalfArea(GetSlot(node, slot)) * (node.Count[slot] > 0 ? (float)node.Count[slot] : 1.0f);
+    return cost;
+}
+
+float BVH::GetCost() const
+{
+    if (m_Nodes.empty())
+        return 0.0f;
+
+    //SAH: every box is entered with a probability proportional to its area, leaves cost one test per object
+    BoundingBox root = EmptyBox();
+    for (int slot = 0; slot < 4; slot++)
+        if (m_Nodes[0].Child[slot] >= 0)
+            Grow(root, GetSlot(m_Nodes[0], slot));
+
+    float cost = 0.0f;
+    for (const BVHNode& node : m_Nodes)
+        cost += NodeCost(node);
+    return cost / std::max(HalfArea(root), FLT_MIN);
+}
+
+void BVH::Query(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+    if (m_Nodes.empty())
+        return;
+
+    std::vector<uint32_t> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const BVHNode& node = m_Nodes[stack.back()];
+        stack.pop_back();
+
+        //the four slots are tested plane by plane, the loops over them are plain arrays the compiler can vectorize
+        float cx[4], cy[4], cz[4], ex[4], ey[4], ez[4];
+        for (int s = 0; s < 4; s++)
+        {
+            cx[s] = (node.MinX[s] + node.MaxX[s]) * 0.5f; ex[s] = (node.MaxX[s] - node.MinX[s]) * 0.5f;
+            cy[s] = (node.MinY[s] + node.MaxY[s]) * 0.5f; ey[s] = (node.MaxY[s] - node.MinY[s]) * 0.5f;
+            cz[s] = (node.MinZ[s] + node.MaxZ[s]) * 0.5f; ez[s] = (node.MaxZ[s] - node.MinZ[s]) * 0.5f;
+        }
+
+        bool outside[4] = {}, inside[4] = { true, true, true, true };
+        for (const glm::vec4& plane : frustum.Planes)
+        {
+            glm::vec3 a = glm::abs(glm::vec3(plane));
+            for (int s = 0; s < 4; s++)
+            {
+                float d = plane.x * cx[s] + plane.y * cy[s] + plane.z * cz[s] + plane.w;
+                float r = a.x * ex[s] + a.y * ey[s] + a.z * ez[s];
+                outside[s] = outside[s] || d < -r;
+                inside[s]  = inside[s] && d >= r;
+            }
+        }
+
+        for (int s = 0; s < 4; s++)
+        {
+            if (node.Child[s] < 0 || outside[s])
+                continue;
+
+            //completely inside: everything below is visible without another test
+            if (inside[s])
+                AppendSubtree(node.Child[s], node.Count[s], visible);
+            else if (node.Count[s] > 0)
+            {
+                for (uint32_t i = 0; i < node.Count[s]; i++)
+                {
+                    uint32_t object = m_Objects[node.Child[s] + i];
+                    const BoundingBox& box = m_Bounds[object];
+                    if (FrustumCulling::IsVisible(frustum, (box.Min + box.Max) * 0.5f, (box.Max - box.Min) * 0.5f))
+                        visible.push_back(object);
+                }
+            }
+            else
+                stack.push_back(node.Child[s]);
+        }
+    }
+}
+
+void BVH::AppendSubtree(int32_t child, uint32_t count, std::vector<uint32_t>& visible) const
+{
+    if (count > 0)
+    {
+        visible.insert(visible.end(), m_Objects.begin() + child, m_Objects.begin() + child + count);
+        return;
+    }
+
+    const BVHNode& node = m_Nodes[child];
+    for (int s = 0; s < 4; s++)
+        if (node.Child[s] >= 0)
+            AppendSubtree(node.Child[s], node.Count[s], visible);
+}
+
+bool BVH::Raycast(const Ray& ray, RayHit& hit, float maxDistance) const
+{
+    if (m_Nodes.empty())
+        return false;
+
+    glm::vec3 inverse = 1.0f / ray.Direction;
+    float closest = maxDistance;
+    uint32_t closestObject = InvalidObject;
+
+    //slab test, returns the entry distance or FLT_MAX on a miss
+    auto intersect = [&](const glm::vec3& min, const glm::vec3& max)
+    {
+        glm::vec3 t0 = (min - ray.Origin) * inverse;
+        glm::vec3 t1 = (max - ray.Origin) * inverse;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar	= glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit	= std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, closest));
+        return enter <= exit ? enter : FLT_MAX;
+    };
+
+    std::vector<uint32_t> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const BVHNode& node = m_Nodes[stack.back()];
+        stack.pop_back();
+
+        float distances[4];
+        int order[4], hits = 0;
+        for (int s = 0; s < 4; s++)
+        {
+            if (node.Child[s] < 0)
+                continue;
+
+            distances[s] = intersect(glm::vec3(node.MinX[s], node.MinY[s], node.MinZ[s]), glm::vec3(node.MaxX[s], node.MaxY[s], node.MaxZ[s]));
+            if (distances[s] != FLT_MAX)
+                order[hits++] = s;
+        }
+
+        //farthest pushed first so the nearest child is visited next and shrinks closest early
+        std::sort(order, order + hits, [&](int a, int b) { return distances[a] > distances[b]; });
+        for (int h = 0; h < hits; h++)
+        {
+            int s = order[h];
+            if (node.Count[s] == 0)
+            {
+                stack.push_back(node.Child[s]);
+                continue;
+            }
+
+            for (uint32_t i = 0; i < node.Count[s]; i++)
+            {
+                uint32_t object = m_Objects[node.Child[s] + i];
+                float distance = intersect(m_Bounds[object].Min, m_Bounds[object].Max);
+                if (distance < closest)
+                {
+                    closest = distance;
+                    closestObject = object;
+                }
+            }
+        }
+    }
+
+    if (closestObject == InvalidObject)
+        return false;
+
+    hit = { closestObject, closest };
+    return true;
+}
+
+uint32_t BVH::Nearest(const glm::vec3& point, float maxDistance) const
+{
+    if (m_Nodes.empty())
+        return InvalidObject;
+
+    auto distanceSquared = [&](const glm::vec3& min, const glm::vec3& max)
+    {
+        glm::vec3 d = glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    };
+
+    float closest = maxDistance == FLT_MAX ? FLT_MAX : maxDistance * maxDistance;
+    uint32_t closestObject = InvalidObject;
+
+    std::vector<uint32_t> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const BVHNode& node = m_Nodes[stack.back()];
+        stack.pop_back();
+
+        float distances[4];
+        int order[4], candidates = 0;
+        for (int s = 0; s < 4; s++)
+        {
+            if (node.Child[s] < 0)
+                continue;
+
+            distances[s] = distanceSquared(glm::vec3(node.MinX[s], node.MinY[s], node.MinZ[s]), glm::vec3(node.MaxX[s], node.MaxY[s], node.MaxZ[s]));
+            if (distances[s] <= closest)
+                order[candidates++] = s;
+        }
+
+        std::sort(order, order + candidates, [&](int a, int b) { return distances[a] > distances[b]; });
+        for (int c = 0; c < candidates; c++)
+        {
+            int s = order[c];
+            if (node.Count[s] == 0)
+            {
+                stack.push_back(node.Child[s]);
+                continue;
+            }
+
+            for (uint32_t i = 0; i < node.Count[s]; i++)
+            {
+                uint32_t object = m_Objects[node.Child[s] + i];
+                float distance = distanceSquared(m_Bounds[object].Min, m_Bounds[object].Max);
+                if (distance <= closest)
+                {
+                    closest = distance;
+                    closestObject = object;
+                }
+            }
+        }
+    }
+
+    return closestObject;
+}
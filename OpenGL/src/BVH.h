@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cfloat>
+
+#include "glm/glm.hpp"
+
+#include "FrustumCulling.h"
+
+struct BoundingBox
+{
+	glm::vec3 Min;
+	glm::vec3 Max;
+};
+
+struct Ray
+{
+	glm::vec3 Origin;
+	glm::vec3 Direction;
+
+	// Through a pixel, for mouse picking. y goes down like window coordinates.
+	static Ray FromScreen(const glm::vec2& pixel, const glm::vec2& viewport, const glm::mat4& viewProjection);
+};
+
+struct RayHit
+{
+	uint32_t Object;
+	float	 Distance; // along the ray, in units of its direction's length
+};
+
+// Four children side by side, 128 bytes: their bounds in SoA form so a node is tested in one go,
+// followed by where they point
+struct BVHNode
+{
+	float	 MinX[4], MinY[4], MinZ[4];
+	float	 MaxX[4], MaxY[4], MaxZ[4];
+	int32_t	 Child[4]; // inner child: node index, leaf: first entry of its objects, -1 if the slot is empty
+	uint32_t Count[4]; // objects in a leaf, 0 for inner children and empty slots
+};
+
+// Bounding volume hierarchy over object bounding boxes. Built top down with binned SAH, big subtrees on
+// separate threads, then collapsed into 4 wide nodes for traversal. Moving objects only need a Refit;
+// Optimize rebuilds once refitting has made the tree noticeably worse than a fresh build, and then only the
+// subtrees under the nodes that got worse.
+class BVH
+{
+private:
+	std::vector<BoundingBox> m_Bounds;	// by object
+	std::vector<uint32_t>	 m_Objects; // leaf order, leaves reference ranges of it
+	std::vector<BVHNode>	 m_Nodes;	// root first, then each child's subtree in turn
+	float					 m_BuiltCost;
+	std::vector<float>		 m_BuiltNodeCosts; // NodeCost of every node when it was built
+
+	// binary tree the build produces before collapsing
+	struct BuildNode
+	{
+		BoundingBox Bounds;
+		uint32_t	Left, Right;
+		uint32_t	Start, Count; // Count > 0 for leaves
+	};
+	std::vector<BuildNode>	m_BuildNodes;
+	std::vector<glm::vec3>	m_Centroids;
+	std::atomic<uint32_t>	m_BuildNodeCount;
+
+public:
+	BVH();
+
+	// threads = 0 uses every hardware thread
+	void Build(const std::vector<BoundingBox>& bounds, unsigned int threads = 0);
+
+	// Takes effect with the next Refit
+	void SetBounds(uint32_t object, const BoundingBox& bounds);
+	void Refit();
+	// Refits, then rebuilds the subtrees under the topmost nodes whose own SAH cost grew by more than
+	// maxDegradation since they were built; objects moving within one part of the scene only rebuild that part.
+	// A full Build if that node is the root, or if no single node got that much worse but the whole tree did.
+	// Returns true if anything was rebuilt.
+	bool Optimize(float maxDegradation = 1.5f);
+
+	// Appends the objects whose boxes intersect the frustum, in tree order
+	void Query(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+	// Closest object box the ray hits within maxDistance
+	bool Raycast(const Ray& ray, RayHit& hit, float maxDistance = FLT_MAX) const;
+	// Object whose box is closest to point, 0xFFFFFFFF if none is within maxDistance
+	uint32_t Nearest(const glm::vec3& point, float maxDistance = FLT_MAX) const;
+
+	// Expected cost of a traversal relative to testing the root, what Optimize compares
+	float GetCost() const;
+
+	inline uint32_t GetObjectCount() const { return (uint32_t)m_Bounds.size(); }
+	inline uint32_t GetNodeCount()	 const { return (uint32_t)m_Nodes.size(); }
+	inline const BoundingBox& GetBounds(uint32_t object) const { return m_Bounds[object]; }
+
+private:
+	void	 BuildRange(uint32_t start, uint32_t count, unsigned int threads);
+	void	 ReleaseBuildData();
+	void	 BuildRecursive(uint32_t node, uint32_t start, uint32_t count, unsigned int depth, unsigned int parallelDepth);
+	uint32_t Collapse(uint32_t buildNode);
+	void	 RebuildSubtrees(const std::vector<uint32_t>& roots);
+	static float NodeCost(const BVHNode& node);
+	void	 AppendSubtree(int32_t child, uint32_t count, std::vector<uint32_t>& visible) const;
+};
@@ -0,0 +1,90 @@
+#include "BindlessTextureTable.h"
+
+#include "Renderer.h"
+#include "Texture.h"
+
+// std140 pads every array element to 16 bytes, so each 64 bit handle takes a uvec4 slot
+static const unsigned int s_HandleStride = 16;
+
+BindlessTextureTable::BindlessTextureTable(unsigned int capacity)
+	: m_BufferID(0), m_Capacity(capacity), m_Bindless(IsSupported())
+{
+	if (!m_Bindless)
+		return;
+
+	//the whole table is one uniform block, which only has to hold 16KB
+	int maxBlockSize;
+	GLCall(glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxBlockSize));
+	ASSERT(m_Capacity > 0 && m_Capacity * s_HandleStride <= (unsigned int)maxBlockSize);
+
+	GLCall(glGenBuffers(1, &m_BufferID));
+	GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_BufferID));
+	GLCall(glBufferData(GL_UNIFORM_BUFFER, m_Capacity * s_HandleStride, nullptr, GL_STATIC_DRAW));
+	GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+BindlessTextureTable::~BindlessTextureTable()
+{
+	if (!m_Bindless)
+		return;
+
+	for (uint64_t handle : m_Handles)
+	{
+		GLCall(glMakeTextureHandleNonResidentARB(handle));
+	}
+	GLCall(glDeleteBuffers(1, &m_BufferID));
+}
+
+int BindlessTextureTable::Add(const Texture& texture)
+{
+	if (m_Textures.size() == m_Capacity)
+		return -1;
+
+	unsigned int index = (unsigned int)m_Textures.size();
+	m_Textures.push_back(&texture);
+
+	if (m_Bindless)
+	{
+		//The handle freezes the texture parameters, so textures must be fully set up by now
+		GLCall(uint64_t handle = glGetTextureHandleARB(texture.GetRendererID()));
+		GLCall(glMakeTextureHandleResidentARB(handle));
+		m_Handles.push_back(handle);
+
+		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_BufferID));
+		GLCall(glBufferSubData(GL_UNIFORM_BUFFER, index * s_HandleStride, sizeof(uint64_t), &handle));
+		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+	}
+
+	return (int)index;
+}
+
+void BindlessTextureTable::Bind(unsigned int bindingPoint) const
+{
+	if (m_Bindless)
+	{
+		GLCall(glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, m_BufferID));
+	}
+}
+
+void BindlessTextureTable::Bind(unsigned int index, unsigned int slot) const
+{
+	if (!m_Bindless)
+		m_Textures[index]->Bind(slot);
+}
+
+const char* BindlessTextureTable::GetShaderPath() const
+{
+	return m_Bindless ? "res/shaders/Bindless.shader" : "res/shaders/BindlessFallback.shader";
+}
+
+std::vector<std::string> BindlessTextureTable::GetShaderDefines() const
+{
+	if (!m_Bindless)
+		return {};
+	return { "TEXTURE_TABLE_CAPACITY=" + std::to_string(m_Capacity) };
+}
+
+bool BindlessTextureTable::IsSupported()
+{
+	return GLEW_ARB_bindless_texture != 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class Texture;
+
+// Keeps ARB_bindless_texture handles of many textures in one uniform buffer so a shader can
+// pick its texture with an index (u_TextureIndex) instead of us binding it before the draw.
+// Without the extension it falls back to classic binding through Bind(index, slot).
+// Draw with GetShaderPath() and GetShaderDefines(): Bindless.shader sized to the capacity, or
+// BindlessFallback.shader which samples u_Texture from the bound slot. The bindless one is GLSL 4.00 as the
+// extension requires, drivers that expose it accept that version even in our 3.3 context.
+class BindlessTextureTable
+{
+private:
+	unsigned int				m_BufferID;
+	unsigned int				m_Capacity;
+	bool						m_Bindless;
+	std::vector<const Texture*> m_Textures;
+	std::vector<uint64_t>		m_Handles;
+
+public:
+	BindlessTextureTable(unsigned int capacity = 256);
+	~BindlessTextureTable();
+
+	BindlessTextureTable(const BindlessTextureTable&) = delete;
+	BindlessTextureTable& operator=(const BindlessTextureTable&) = delete;
+
+	// Returns the index the shader uses to look the texture up, or -1 if the table is full
+	int Add(const Texture& texture);
+
+	// Bindless: bind the handle buffer once per frame. Fallback: does nothing
+	void Bind(unsigned int bindingPoint) const;
+	// Bindless: does nothing. Fallback: regular Texture::Bind for this entry
+	void Bind(unsigned int index, unsigned int slot) const;
+
+	inline bool			IsBindless() const { return m_Bindless; }
+	inline unsigned int GetCount()	 const { return (unsigned int)m_Textures.size(); }
+
+	// The shader matching IsBindless(), and the defines sizing its handle array to the capacity
+	const char*				 GetShaderPath() const;
+	std::vector<std::string> GetShaderDefines() const;
+
+	static bool IsSupported();
+};
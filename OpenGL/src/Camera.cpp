@@ -0,0 +1,207 @@
+#include "Camera.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+Camera::Camera()
+    : m_Position(0.0f), m_Rotation(1.0f, 0.0f, 0.0f, 0.0f), m_Jitter(0.0f),
+      m_ViewDirty(true), m_ProjectionDirty(true), m_Version(0), m_ViewportSize(1.0f)
+{
+}
+
+void Camera::MarkProjectionDirty()
+{
+    m_ProjectionDirty = true;
+    m_Version++;
+}
+
+//setting the same value again is free, so callers can set every frame
+void Camera::SetPosition(const glm::vec3& position)
+{
+    if (position == m_Position)
+        return;
+    m_Position = position;
+    m_ViewDirty = true;
+    m_Version++;
+}
+
+void Camera::SetRotation(const glm::quat& rotation)
+{
+    if (rotation == m_Rotation)
+        return;
+    m_Rotation = rotation;
+    m_ViewDirty = true;
+    m_Version++;
+}
+
+void Camera::SetViewportSize(float width, float height)
+{
+    glm::vec2 size(width, height);
+    if (size == m_ViewportSize)
+        return;
+    m_ViewportSize = size;
+    if (m_Jitter != glm::vec2(0.0f))
+        MarkProjectionDirty();
+}
+
+void Camera::SetJitter(const glm::vec2& jitter)
+{
+    if (jitter == m_Jitter)
+        return;
+    m_Jitter = jitter;
+    MarkProjectionDirty();
+}
+
+void Camera::Update() const
+{
+    if (!m_ViewDirty && !m_ProjectionDirty)
+        return;
+
+    if (m_ViewDirty)
+    {
+        m_InverseView = glm::translate(glm::mat4(1.0f), m_Position) * glm::mat4_cast(m_Rotation);
+        m_View = glm::inverse(m_InverseView);
+    }
+
+    if (m_ProjectionDirty)
+    {
+        m_Projection = ComputeProjection();
+
+        //a translation in clip space moves every point by the same amount in NDC, whatever the projection
+        glm::vec2 offset = 2.0f * m_Jitter / m_ViewportSize;
+        m_JitteredProjection = glm::translate(glm::mat4(1.0f), glm::vec3(offset, 0.0f)) * m_Projection;
+    }
+
+    m_ViewProjection = m_JitteredProjection * m_View;
+    m_UnjitteredViewProjection = m_Projection * m_View;
+    m_InverseViewProjection = glm::inverse(m_UnjitteredViewProjection);
+    m_Frustum = Frustum(m_UnjitteredViewProjection);
+
+    m_ViewDirty = false;
+    m_ProjectionDirty = false;
+}
+
+const glm::mat4& Camera::GetView() const
+{
+    Update();
+    return m_View;
+}
+
+const glm::mat4& Camera::GetInverseView() const
+{
+    Update();
+    return m_InverseView;
+}
+
+const glm::mat4& Camera::GetProjection() const
+{
+    Update();
+    return m_JitteredProjection;
+}
+
+const glm::mat4& Camera::GetViewProjection() const
+{
+    Update();
+    return m_ViewProjection;
+}
+
+const glm::mat4& Camera::GetUnjitteredProjection() const
+{
+    Update();
+    return m_Projection;
+}
+
+const glm::mat4& Camera::GetUnjitteredViewProjection() const
+{
+    Update();
+    return m_UnjitteredViewProjection;
+}
+
+const glm::mat4& Camera::GetInverseViewProjection() const
+{
+    Update();
+    return m_InverseViewProjection;
+}
+
+const Frustum& Camera::GetFrustum() const
+{
+    Update();
+    return m_Frustum;
+}
+
+static float RadicalInverse(uint32_t index, uint32_t base)
+{
+    float result = 0.0f;
+    float fraction = 1.0f / base;
+    while (index > 0)
+    {
+        result += (index % base) * fraction;
+        index /= base;
+        fraction /= base;
+    }
+    return result;
+}
+
+glm::vec2 Camera::GetHaltonJitter(uint32_t index)
+{
+    //index 0 of the sequence is 0, 0 which would repeat the unjittered image, start at 1
+    return glm::vec2(RadicalInverse(index + 1, 2), RadicalInverse(index + 1, 3)) - 0.5f;
+}
+
+OrthographicCamera::OrthographicCamera(float left, float right, float bottom, float top, float nearPlane, float farPlane)
+    : m_Left(left), m_Right(right), m_Bottom(bottom), m_Top(top), m_Near(nearPlane), m_Far(farPlane)
+{
+}
+
+void OrthographicCamera::SetProjection(float left, float right, float bottom, float top, float nearPlane, float farPlane)
+{
+    if (left == m_Left && right == m_Right && bottom == m_Bottom && top == m_Top && nearPlane == m_Near && farPlane == m_Far)
+        return;
+
+    m_Left	 = left;
+    m_Right	 = right;
+    m_Bottom = bottom;
+    m_Top	 = top;
+    m_Near	 = nearPlane;
+    m_Far	 = farPlane;
+    MarkProjectionDirty();
+}
+
+glm::mat4 OrthographicCamera::ComputeProjection() const
+{
+    return glm::ortho(m_Left, m_Right, m_Bottom, m_Top, m_Near, m_Far);
+}
+
+PerspectiveCamera::PerspectiveCamera(float fieldOfView, float aspectRatio, float nearPlane, float farPlane)
+    : m_FieldOfView(fieldOfView), m_AspectRatio(aspectRatio), m_Near(nearPlane), m_Far(farPlane)
+{
+}
+
+void PerspectiveCamera::SetFieldOfView(float fieldOfView)
+{
+    if (fieldOfView == m_FieldOfView)
+        return;
+    m_FieldOfView = fieldOfView;
+    MarkProjectionDirty();
+}
+
+void PerspectiveCamera::SetAspectRatio(float aspectRatio)
+{
+    if (aspectRatio == m_AspectRatio)
+        return;
+    m_AspectRatio = aspectRatio;
+    MarkProjectionDirty();
+}
+
+void PerspectiveCamera::SetClipPlanes(float nearPlane, float farPlane)
+{
+    if (nearPlane == m_Near && farPlane == m_Far)
+        return;
+    m_Near = nearPlane;
+    m_Far  = farPlane;
+    MarkProjectionDirty();
+}
+
+glm::mat4 PerspectiveCamera::ComputeProjection() const
+{
+    return glm::perspective(m_FieldOfView, m_AspectRatio, m_Near, m_Far);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include "FrustumCulling.h"
+
+// A camera placed with a position and a rotation, the projection comes from the derived class. The matrices, their
+// inverses and the frustum are cached: setters that change something only mark them, the next getter recomputes
+// them once. Every change bumps the version, so whoever uploads the camera (CameraBlock, culling planes) compares
+// it with the version it uploaded last and skips the work when nothing moved.
+// Jitter shifts the projection by a sub pixel offset for temporal techniques. It is left out of the unjittered
+// matrices and the frustum, culling and reprojection should not shake with it.
+class Camera
+{
+private:
+	glm::vec3 m_Position;
+	glm::quat m_Rotation;
+	glm::vec2 m_Jitter; // in pixels
+
+	mutable glm::mat4 m_View;
+	mutable glm::mat4 m_InverseView;
+	mutable glm::mat4 m_Projection;
+	mutable glm::mat4 m_JitteredProjection;
+	mutable glm::mat4 m_ViewProjection;
+	mutable glm::mat4 m_UnjitteredViewProjection;
+	mutable glm::mat4 m_InverseViewProjection;
+	mutable Frustum	  m_Frustum;
+	mutable bool	  m_ViewDirty;
+	mutable bool	  m_ProjectionDirty;
+
+	uint32_t  m_Version;
+
+	void Update() const;
+
+protected:
+	glm::vec2 m_ViewportSize; // in pixels, for the jitter
+
+	// Call from setters of projection parameters
+	void MarkProjectionDirty();
+	virtual glm::mat4 ComputeProjection() const = 0;
+
+public:
+	Camera();
+	virtual ~Camera() = default;
+
+	void SetPosition(const glm::vec3& position);
+	void SetRotation(const glm::quat& rotation);
+	void SetViewportSize(float width, float height);
+	// Offset in pixels, usually within -0.5..0.5, see GetHaltonJitter
+	void SetJitter(const glm::vec2& jitter);
+
+	inline const glm::vec3& GetPosition()	  const { return m_Position; }
+	inline const glm::quat& GetRotation()	  const { return m_Rotation; }
+	inline const glm::vec2& GetViewportSize() const { return m_ViewportSize; }
+	inline const glm::vec2& GetJitter()		  const { return m_Jitter; }
+
+	const glm::mat4& GetView() const;
+	const glm::mat4& GetInverseView() const;
+	const glm::mat4& GetProjection() const; // jittered
+	const glm::mat4& GetViewProjection() const; // jittered
+	const glm::mat4& GetUnjitteredProjection() const;
+	const glm::mat4& GetUnjitteredViewProjection() const;
+	const glm::mat4& GetInverseViewProjection() const; // of the unjittered one
+	const Frustum&	 GetFrustum() const; // of the unjittered view projection
+
+	inline uint32_t GetVersion() const { return m_Version; }
+
+	// Point index of the Halton (2, 3) sequence, centered on 0 so it fits SetJitter
+	static glm::vec2 GetHaltonJitter(uint32_t index);
+};
+
+class OrthographicCamera : public Camera
+{
+private:
+	float m_Left, m_Right, m_Bottom, m_Top, m_Near, m_Far;
+
+	glm::mat4 ComputeProjection() const override;
+
+public:
+	OrthographicCamera(float left, float right, float bottom, float top, float nearPlane = -1.0f, float farPlane = 1.0f);
+
+	void SetProjection(float left, float right, float bottom, float top, float nearPlane = -1.0f, float farPlane = 1.0f);
+};
+
+class PerspectiveCamera : public Camera
+{
+private:
+	float m_FieldOfView; // vertical, in radians
+	float m_AspectRatio;
+	float m_Near, m_Far;
+
+	glm::mat4 ComputeProjection() const override;
+
+public:
+	PerspectiveCamera(float fieldOfView, float aspectRatio, float nearPlane = 0.1f, float farPlane = 1000.0f);
+
+	void SetFieldOfView(float fieldOfView);
+	void SetAspectRatio(float aspectRatio);
+	void SetClipPlanes(float nearPlane, float farPlane);
+
+	inline float GetFieldOfView() const { return m_FieldOfView; }
+	inline float GetAspectRatio() const { return m_AspectRatio; }
+	inline float GetNear()		  const { return m_Near; }
+	inline float GetFar()		  const { return m_Far; }
+};
@@ -0,0 +1,96 @@
+#include "CpuFeatures.h"
+
+#include <atomic>
+#include <algorithm>
+
+#if CPU_X86
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+#if CPU_X86
+static void CpuId(int leaf, int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, leaf, subleaf);
+    for (int i = 0; i < 4; i++)
+        regs[i] = (unsigned int)info[i];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long XGetBV()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+#endif
+
+static CpuFeatures Detect()
+{
+    CpuFeatures features = {};
+#if CPU_X86
+    unsigned int regs[4];
+    CpuId(0, 0, regs);
+    unsigned int maxLeaf = regs[0];
+
+    CpuId(1, 0, regs);
+    features.SSE41 = (regs[2] & (1u << 19)) != 0;
+    features.FMA   = (regs[2] & (1u << 12)) != 0;
+
+    //the cpu having AVX isn't enough, the OS has to preserve xmm and ymm state across context switches
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx     = (regs[2] & (1u << 28)) != 0;
+    features.AVX = avx && osxsave && (XGetBV() & 0x6) == 0x6;
+
+    if (maxLeaf >= 7)
+    {
+        CpuId(7, 0, regs);
+        features.AVX2 = features.AVX && (regs[1] & (1u << 5)) != 0;
+    }
+    features.FMA = features.FMA && features.AVX;
+#endif
+    return features;
+}
+
+const CpuFeatures& CpuFeatures::Get()
+{
+    static CpuFeatures s_Features = Detect();
+    return s_Features;
+}
+
+static SimdLevel BestSimdLevel()
+{
+#if CPU_X86
+    const CpuFeatures& features = CpuFeatures::Get();
+    return features.AVX2 && features.FMA ? SimdLevel::AVX2 : SimdLevel::SSE;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+static std::atomic<int>& CurrentSimdLevel()
+{
+    static std::atomic<int> s_Level((int)BestSimdLevel());
+    return s_Level;
+}
+
+SimdLevel CpuFeatures::GetSimdLevel()
+{
+    return (SimdLevel)CurrentSimdLevel().load(std::memory_order_relaxed);
+}
+
+void CpuFeatures::SetSimdLevel(SimdLevel level)
+{
+    CurrentSimdLevel().store(std::min((int)level, (int)BestSimdLevel()), std::memory_order_relaxed);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// x86 kernels are compiled into every build and picked at runtime, so one binary runs everywhere
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define CPU_X86 1
+#else
+	#define CPU_X86 0
+#endif
+
+// MSVC emits AVX intrinsics without /arch, gcc and clang need them enabled per function
+#if CPU_X86 && !defined(_MSC_VER)
+	#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+	#define TARGET_AVX2
+#endif
+
+// Widest kernels the dispatchers in FrustumCulling and TransformKernels pick
+enum class SimdLevel
+{
+	Scalar,
+	SSE,	// SSE2, every x64 CPU
+	AVX2	// with FMA
+};
+
+// What the CPU and the OS support, queried once with cpuid. AVX also needs the OS to save the ymm registers.
+struct CpuFeatures
+{
+	bool SSE41;
+	bool AVX;
+	bool AVX2;
+	bool FMA;
+
+	static const CpuFeatures& Get();
+
+	// The best level the CPU supports unless lowered with SetSimdLevel, e.g. by a benchmark comparing the paths.
+	// Levels above what the CPU supports are clamped.
+	static SimdLevel GetSimdLevel();
+	static void		 SetSimdLevel(SimdLevel level);
+};
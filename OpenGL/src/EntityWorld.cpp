@@ -0,0 +1,207 @@
+#include "EntityWorld.h"
+
+static const uint32_t FreeRecord = 0xFFFFFFFF;
+
+// Arrays in a chunk start 16 byte aligned, SIMD loads of component arrays never straddle a line needlessly
+static const unsigned int ColumnAlignment = 16;
+
+static unsigned int AlignUp(unsigned int value, unsigned int alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+std::vector<EntityWorld::ComponentInfo>& EntityWorld::GetComponentInfos()
+{
+    static std::vector<ComponentInfo> s_Infos;
+    return s_Infos;
+}
+
+uint32_t EntityWorld::RegisterComponent(unsigned int size, unsigned int alignment)
+{
+    std::vector<ComponentInfo>& infos = GetComponentInfos();
+    ASSERT(infos.size() < 64 && alignment <= ColumnAlignment);
+    infos.push_back({ size, alignment });
+    return (uint32_t)infos.size() - 1;
+}
+
+EntityWorld::EntityWorld()
+    : m_EntityCount(0)
+{
+}
+
+uint32_t EntityWorld::FindArchetype(uint64_t signature)
+{
+    for (uint32_t i = 0; i < m_Archetypes.size(); i++)
+        if (m_Archetypes[i]->Signature == signature)
+            return i;
+
+    std::unique_ptr<Archetype> archetype(new Archetype());
+    archetype->Signature = signature;
+    std::fill(archetype->Columns, archetype->Columns + 64, -1);
+
+    unsigned int bytesPerEntity = sizeof(Entity);
+    for (uint32_t type = 0; type < 64; type++)
+    {
+        if (!((signature >> type) & 1))
+            continue;
+        archetype->Columns[type] = (int)archetype->Types.size();
+        archetype->Types.push_back(type);
+        bytesPerEntity += GetComponentInfos()[type].Size;
+    }
+
+    //as many entities as fit with every array padded to its alignment
+    uint32_t capacity = std::max(1u, (ChunkSize - ColumnAlignment * ((unsigned int)archetype->Types.size() + 1)) / bytesPerEntity);
+    unsigned int offset = AlignUp(capacity * sizeof(Entity), ColumnAlignment);
+    for (uint32_t type : archetype->Types)
+    {
+        archetype->Offsets.push_back(offset);
+        offset = AlignUp(offset + capacity * GetComponentInfos()[type].Size, ColumnAlignment);
+    }
+    ASSERT(offset <= ChunkSize);
+    archetype->Capacity = capacity;
+
+    m_Archetypes.push_back(std::move(archetype));
+    return (uint32_t)m_Archetypes.size() - 1;
+}
+
+Entity EntityWorld::CreateEntity(uint32_t archetype)
+{
+    uint32_t index;
+    if (!m_FreeIndices.empty())
+    {
+        index = m_FreeIndices.back();
+        m_FreeIndices.pop_back();
+    }
+    else
+    {
+        index = (uint32_t)m_Records.size();
+        m_Records.push_back({ FreeRecord, 0, 0, 0 });
+    }
+
+    Record& record = m_Records[index];
+    Allocate(archetype, record, index);
+    m_EntityCount++;
+    return { index, record.Generation };
+}
+
+void EntityWorld::Destroy(Entity entity)
+{
+    if (!IsAlive(entity))
+        return;
+
+    Record& record = m_Records[entity.Index];
+    Free(record);
+    record.Archetype = FreeRecord;
+    record.Generation++;
+    m_FreeIndices.push_back(entity.Index);
+    m_EntityCount--;
+}
+
+bool EntityWorld::IsAlive(Entity entity) const
+{
+    return entity.Index < m_Records.size() && m_Records[entity.Index].Archetype != FreeRecord && m_Records[entity.Index].Generation == entity.Generation;
+}
+
+void* EntityWorld::GetComponent(Entity entity, uint32_t type)
+{
+    if (!IsAlive(entity))
+        return nullptr;
+
+    const Record& record = m_Records[entity.Index];
+    const Archetype& archetype = *m_Archetypes[record.Archetype];
+    int column = archetype.Columns[type];
+    if (column < 0)
+        return nullptr;
+
+    return archetype.Chunks[record.Chunk].Data.get() + archetype.Offsets[column] + (size_t)record.Row * GetComponentInfos()[type].Size;
+}
+
+// Appends a row to the archetype's last chunk, starting a new one when it is full
+void EntityWorld::Allocate(uint32_t archetypeIndex, Record& record, uint32_t index)
+{
+    Archetype& archetype = *m_Archetypes[archetypeIndex];
+    if (archetype.Chunks.empty() || archetype.Chunks.back().Count == archetype.Capacity)
+        archetype.Chunks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[ChunkSize]), 0 });
+
+    Chunk& chunk = archetype.Chunks.back();
+    record.Archetype = archetypeIndex;
+    record.Chunk	 = (uint32_t)archetype.Chunks.size() - 1;
+    record.Row		 = chunk.Count++;
+    ((Entity*)chunk.Data.get())[record.Row] = { index, record.Generation };
+}
+
+// The archetype's last entity fills the hole, so every chunk but the last stays full
+void EntityWorld::Free(const Record& record)
+{
+    Archetype& archetype = *m_Archetypes[record.Archetype];
+    Chunk& last = archetype.Chunks.back();
+    uint32_t lastRow = last.Count - 1;
+    Chunk& chunk = archetype.Chunks[record.Chunk];
+
+    if (&chunk != &last || record.Row != lastRow)
+    {
+        Entity moved = ((Entity*)last.Data.get())[lastRow];
+        ((Entity*)chunk.Data.get())[record.Row] = moved;
+        for (size_t c = 0; c < archetype.Types.size(); c++)
+        {
+            unsigned int size = GetComponentInfos()[archetype.Types[c]].Size;
+            std::memcpy(chunk.Data.get() + archetype.Offsets[c] + (size_t)record.Row * size,
+                        last.Data.get() + archetype.Offsets[c] + (size_t)lastRow * size, size);
+        }
+
+        Record& movedRecord = m_Records[moved.Index];
+        movedRecord.Chunk = record.Chunk;
+        movedRecord.Row	  = record.Row;
+    }
+
+    if (--last.Count == 0)
+        archetype.Chunks.pop_back();
+}
+
+// Copies the components both archetypes have, the ones only the new one has are left for the caller to set
+void EntityWorld::Move(Entity entity, uint64_t signature)
+{
+    uint32_t target = FindArchetype(signature);
+    Record& record = m_Records[entity.Index];
+    Record old = record;
+
+    Allocate(target, record, entity.Index);
+
+    const Archetype& from = *m_Archetypes[old.Archetype];
+    const Archetype& to = *m_Archetypes[target];
+    for (size_t c = 0; c < to.Types.size(); c++)
+    {
+        int column = from.Columns[to.Types[c]];
+        if (column < 0)
+            continue;
+
+        unsigned int size = GetComponentInfos()[to.Types[c]].Size;
+        std::memcpy(to.Chunks[record.Chunk].Data.get() + to.Offsets[c] + (size_t)record.Row * size,
+                    from.Chunks[old.Chunk].Data.get() + from.Offsets[column] + (size_t)old.Row * size, size);
+    }
+
+    Free(old);
+}
+
+std::vector<EntityWorld::ChunkRef> EntityWorld::GatherChunks(uint64_t signature) const
+{
+    std::vector<ChunkRef> chunks;
+    for (uint32_t a = 0; a < m_Archetypes.size(); a++)
+    {
+        const Archetype& archetype = *m_Archetypes[a];
+        if ((archetype.Signature & signature) != signature)
+            continue;
+
+        for (uint32_t c = 0; c < archetype.Chunks.size(); c++)
+            chunks.push_back({ a, c, archetype.Chunks[c].Count });
+    }
+    return chunks;
+}
+
+uint32_t EntityWorld::GetChunkCount() const
+{
+    uint32_t count = 0;
+    for (const auto& archetype : m_Archetypes)
+        count += (uint32_t)archetype->Chunks.size();
+    return count;
+}
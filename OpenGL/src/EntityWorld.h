@@ -0,0 +1,254 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <future>
+#include <thread>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <cstring>
+#include <cstdint>
+
+#include "Renderer.h"
+
+// Handle to an entity. The generation changes when the index is reused, so stale handles are detected.
+struct Entity
+{
+	uint32_t Index;
+	uint32_t Generation;
+
+	bool operator==(const Entity& other) const { return Index == other.Index && Generation == other.Generation; }
+	bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+static const Entity InvalidEntity = { 0xFFFFFFFF, 0 };
+
+// Entity component storage grouped by archetype: all entities with exactly the same set of components share an
+// archetype, which stores them in fixed size chunks with one contiguous array per component. Iterating a set of
+// components walks those arrays linearly, and chunks are independent, so ForEach spreads them over threads.
+// Adding or removing a component moves the entity to another archetype. Components are plain data, copied with
+// memcpy; at most 64 component types exist.
+class EntityWorld
+{
+public:
+	static const unsigned int ChunkSize = 16 * 1024;
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr<unsigned char[]> Data;
+		uint32_t						 Count;
+	};
+
+	struct Archetype
+	{
+		uint64_t			  Signature; // bit per component type
+		std::vector<uint32_t> Types;	 // sorted
+		std::vector<uint32_t> Offsets;	 // of each type's array in a chunk, the Entity array is at 0
+		int					  Columns[64]; // type -> index into Types, -1 if absent
+		uint32_t			  Capacity;	 // entities per chunk
+		std::vector<Chunk>	  Chunks;	 // all full but the last
+	};
+
+	struct Record
+	{
+		uint32_t Archetype; // UINT32_MAX if the index is free
+		uint32_t Chunk;
+		uint32_t Row;
+		uint32_t Generation;
+	};
+
+	struct ComponentInfo
+	{
+		unsigned int Size;
+		unsigned int Alignment;
+	};
+
+	std::vector<std::unique_ptr<Archetype>> m_Archetypes;
+	std::vector<Record>						m_Records; // by entity index
+	std::vector<uint32_t>					m_FreeIndices;
+	uint32_t								m_EntityCount;
+
+	static std::vector<ComponentInfo>& GetComponentInfos();
+	static uint32_t RegisterComponent(unsigned int size, unsigned int alignment);
+
+public:
+	EntityWorld();
+
+	EntityWorld(const EntityWorld&) = delete;
+	EntityWorld& operator=(const EntityWorld&) = delete;
+
+	// Stable id of a component type, assigned on first use
+	template<typename T>
+	static uint32_t GetTypeID()
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "components are moved with memcpy");
+		static const uint32_t s_ID = RegisterComponent(sizeof(T), alignof(T));
+		return s_ID;
+	}
+
+	template<typename... Components>
+	Entity Create(const Components&... components)
+	{
+		uint32_t types[] = { GetTypeID<Components>()... };
+		Entity entity = CreateEntity(FindArchetype(Signature<Components...>()));
+		const void* data[] = { &components... };
+		for (size_t i = 0; i < sizeof...(Components); i++)
+			std::memcpy(GetComponent(entity, types[i]), data[i], GetComponentInfos()[types[i]].Size);
+		return entity;
+	}
+
+	void Destroy(Entity entity);
+	bool IsAlive(Entity entity) const;
+
+	// nullptr if the entity doesn't have it. Valid until the next structural change (create, destroy, add, remove).
+	template<typename T>
+	T* Get(Entity entity) { return (T*)GetComponent(entity, GetTypeID<T>()); }
+
+	// False for an entity that isn't alive
+	template<typename T>
+	bool Has(Entity entity) const
+	{
+		if (!IsAlive(entity))
+			return false;
+
+		const Record& record = m_Records[entity.Index];
+		return (m_Archetypes[record.Archetype]->Signature >> GetTypeID<T>()) & 1;
+	}
+
+	// Sets the component, moving the entity to the archetype with it if it didn't have one yet. Stale handles are ignored.
+	template<typename T>
+	void Add(Entity entity, const T& component)
+	{
+		if (!IsAlive(entity))
+			return;
+
+		uint32_t type = GetTypeID<T>();
+		if (!Has<T>(entity))
+			Move(entity, m_Archetypes[m_Records[entity.Index].Archetype]->Signature | (1ull << type));
+		std::memcpy(GetComponent(entity, type), &component, sizeof(T));
+	}
+
+	// Stale handles are ignored, Has is false for them
+	template<typename T>
+	void Remove(Entity entity)
+	{
+		if (Has<T>(entity))
+			Move(entity, m_Archetypes[m_Records[entity.Index].Archetype]->Signature & ~(1ull << GetTypeID<T>()));
+	}
+
+	// f(uint32_t count, const Entity* entities, Components*... arrays) once per chunk holding all of Components.
+	// threads = 0 uses every hardware thread, 1 stays on the calling thread; f must be safe to call concurrently
+	// for different chunks. No structural changes inside f.
+	template<typename... Components, typename F>
+	void ForEachChunk(F f, unsigned int threads = 0)
+	{
+		uint32_t types[] = { GetTypeID<Components>()... };
+		std::vector<ChunkRef> chunks = GatherChunks(Signature<Components...>());
+
+		RunChunks(chunks, threads, [this, &f, &types](const ChunkRef& ref)
+		{
+			const Archetype& archetype = *m_Archetypes[ref.Archetype];
+			const Chunk& chunk = archetype.Chunks[ref.Chunk];
+			uint32_t offsets[sizeof...(Components)];
+			for (size_t i = 0; i < sizeof...(Components); i++)
+				offsets[i] = archetype.Offsets[archetype.Columns[types[i]]];
+			CallChunk<Components...>(f, chunk.Count, chunk.Data.get(), offsets, std::index_sequence_for<Components...>());
+		});
+	}
+
+	// f(Components&... components) for every entity holding all of Components, see ForEachChunk
+	template<typename... Components, typename F>
+	void ForEach(F f, unsigned int threads = 0)
+	{
+		ForEachChunk<Components...>([&f](uint32_t count, const Entity*, Components*... arrays)
+		{
+			for (uint32_t i = 0; i < count; i++)
+				f(arrays[i]...);
+		}, threads);
+	}
+
+	inline uint32_t GetEntityCount()	const { return m_EntityCount; }
+	inline uint32_t GetArchetypeCount() const { return (uint32_t)m_Archetypes.size(); }
+	// Every Entity::Index so far is below this, for tables indexed by entity
+	inline uint32_t GetIndexLimit()		const { return (uint32_t)m_Records.size(); }
+	uint32_t		GetChunkCount()		const;
+
+private:
+	struct ChunkRef
+	{
+		uint32_t Archetype;
+		uint32_t Chunk;
+		uint32_t Count;
+	};
+
+	template<typename... Components, typename F, size_t... I>
+	static void CallChunk(F& f, uint32_t count, unsigned char* data, const uint32_t* offsets, std::index_sequence<I...>)
+	{
+		f(count, (const Entity*)data, (Components*)(data + offsets[I])...);
+	}
+
+	template<typename... Components>
+	static uint64_t Signature()
+	{
+		static_assert(sizeof...(Components) > 0, "at least one component");
+		uint64_t signature = 0;
+		uint32_t types[] = { GetTypeID<Components>()... };
+		for (uint32_t type : types)
+			signature |= 1ull << type;
+		return signature;
+	}
+
+	// Below this many entities the threads cost more than they save
+	static const uint32_t ParallelThreshold = 16 * 1024;
+
+	template<typename F>
+	void RunChunks(const std::vector<ChunkRef>& chunks, unsigned int threads, F run)
+	{
+		uint32_t total = 0;
+		for (const ChunkRef& ref : chunks)
+			total += ref.Count;
+
+		if (threads == 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+
+		if (threads == 1 || total < ParallelThreshold)
+		{
+			for (const ChunkRef& ref : chunks)
+				run(ref);
+			return;
+		}
+
+		//contiguous runs of chunks with about the same number of entities per thread
+		uint32_t perThread = total / threads + 1;
+		std::vector<std::future<void>> jobs;
+		size_t first = 0;
+		uint32_t assigned = 0;
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			assigned += chunks[i].Count;
+			if (assigned < perThread && i + 1 < chunks.size())
+				continue;
+
+			jobs.push_back(std::async(std::launch::async, [&chunks, &run, first, i]()
+			{
+				for (size_t j = first; j <= i; j++)
+					run(chunks[j]);
+			}));
+			first = i + 1;
+			assigned = 0;
+		}
+
+		for (auto& job : jobs)
+			job.wait();
+	}
+
+	uint32_t			  FindArchetype(uint64_t signature);
+	Entity				  CreateEntity(uint32_t archetype);
+	void*				  GetComponent(Entity entity, uint32_t type);
+	void				  Move(Entity entity, uint64_t signature);
+	void				  Allocate(uint32_t archetype, Record& record, uint32_t index);
+	void				  Free(const Record& record);
+	std::vector<ChunkRef> GatherChunks(uint64_t signature) const;
+};
@@ -0,0 +1,91 @@
+#include "FileWatcher.h"
+
+#include <iostream>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+FileWatcher::FileWatcher()
+{
+#ifdef __linux__
+	m_Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_Fd < 0)
+		std::cout << "Warning: inotify unavailable, file changes won't be detected" << std::endl;
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+	if (m_Fd >= 0)
+		close(m_Fd);
+#endif
+}
+
+void FileWatcher::Watch(const std::string& path)
+{
+	if (!m_Files.insert(path).second)
+		return;
+
+#ifdef __linux__
+	if (m_Fd < 0)
+		return;
+
+	//Watch the directory rather than the file: most editors save by writing a new file and renaming it over the old one
+	size_t slash = path.find_last_of('/');
+	std::string directory = slash == std::string::npos ? "." : path.substr(0, slash);
+	for (const auto& watched : m_Directories)
+		if (watched.second == directory)
+			return;
+
+	int wd = inotify_add_watch(m_Fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (wd >= 0)
+		m_Directories[wd] = directory;
+#else
+	struct stat info;
+	m_ModifiedTimes[path] = stat(path.c_str(), &info) == 0 ? (long long)info.st_mtime : 0;
+#endif
+}
+
+std::vector<std::string> FileWatcher::Poll()
+{
+	std::unordered_set<std::string> changed;
+
+#ifdef __linux__
+	if (m_Fd < 0)
+		return {};
+
+	alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+	ssize_t length;
+	while ((length = read(m_Fd, buffer, sizeof(buffer))) > 0)
+	{
+		for (char* ptr = buffer; ptr < buffer + length; ptr += sizeof(inotify_event) + ((inotify_event*)ptr)->len)
+		{
+			const inotify_event* event = (const inotify_event*)ptr;
+			auto directory = m_Directories.find(event->wd);
+			if (event->len == 0 || directory == m_Directories.end())
+				continue;
+
+			std::string path = directory->second == "." ? event->name : directory->second + "/" + event->name;
+			if (m_Files.count(path))
+				changed.insert(path);
+		}
+	}
+#else
+	for (auto& file : m_ModifiedTimes)
+	{
+		struct stat info;
+		if (stat(file.first.c_str(), &info) != 0 || (long long)info.st_mtime == file.second)
+			continue;
+
+		file.second = (long long)info.st_mtime;
+		changed.insert(file.first);
+	}
+#endif
+
+	return std::vector<std::string>(changed.begin(), changed.end());
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// Reports files that changed on disk since the last Poll.
+// Uses inotify on Linux; elsewhere it falls back to comparing modification times on every Poll.
+class FileWatcher
+{
+private:
+	std::unordered_set<std::string>			m_Files;
+#ifdef __linux__
+	int										m_Fd;
+	std::unordered_map<int, std::string>	m_Directories;	// watch descriptor -> directory
+#else
+	std::unordered_map<std::string, long long> m_ModifiedTimes;
+#endif
+
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	void Watch(const std::string& path);
+
+	// Non-blocking, every changed path is reported once even if it was written several times
+	std::vector<std::string> Poll();
+};
@@ -0,0 +1,306 @@
+#include "FrustumCulling.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <cmath>
+
+#include "CpuFeatures.h"
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+// Smaller sets finish before a thread would have started
+static const uint32_t MinPerJob = 64 * 1024;
+
+typedef void (*SphereKernel)(const Frustum&, const BoundingSpheres&, uint32_t, uint32_t, std::vector<uint32_t>&);
+typedef void (*BoxKernel)(const Frustum&, const BoundingBoxes&, uint32_t, uint32_t, std::vector<uint32_t>&);
+
+Frustum::Frustum(const glm::mat4& m)
+{
+    //rows of the matrix, glm stores columns
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Planes[0] = row3 + row0;
+    Planes[1] = row3 - row0;
+    Planes[2] = row3 + row1;
+    Planes[3] = row3 - row1;
+    Planes[4] = row3 + row2;
+    Planes[5] = row3 - row2;
+
+    //normalized so plane distances compare against radii in world units
+    for (glm::vec4& plane : Planes)
+        plane /= glm::length(glm::vec3(plane));
+}
+
+void BoundingSpheres::Add(const glm::vec3& center, float radius)
+{
+    X.push_back(center.x);
+    Y.push_back(center.y);
+    Z.push_back(center.z);
+    Radius.push_back(radius);
+}
+
+void BoundingBoxes::Add(const glm::vec3& min, const glm::vec3& max)
+{
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    CenterX.push_back(center.x);
+    CenterY.push_back(center.y);
+    CenterZ.push_back(center.z);
+    ExtentX.push_back(extent.x);
+    ExtentY.push_back(extent.y);
+    ExtentZ.push_back(extent.z);
+}
+
+bool FrustumCulling::IsVisible(const Frustum& frustum, const glm::vec3& center, float radius)
+{
+    for (const glm::vec4& plane : frustum.Planes)
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    return true;
+}
+
+bool FrustumCulling::IsVisible(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extent)
+{
+    for (const glm::vec4& plane : frustum.Planes)
+    {
+        //projected half size of the box onto the plane normal
+        float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+static void CullSpheresScalar(const Frustum& frustum, const BoundingSpheres& spheres, uint32_t begin, uint32_t end, std::vector<uint32_t>& visible)
+{
+    for (uint32_t i = begin; i < end; i++)
+        if (FrustumCulling::IsVisible(frustum, glm::vec3(spheres.X[i], spheres.Y[i], spheres.Z[i]), spheres.Radius[i]))
+            visible.push_back(i);
+}
+
+static void CullBoxesScalar(const Frustum& frustum, const BoundingBoxes& boxes, uint32_t begin, uint32_t end, std::vector<uint32_t>& visible)
+{
+    for (uint32_t i = begin; i < end; i++)
+        if (FrustumCulling::IsVisible(frustum, glm::vec3(boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]), glm::vec3(boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i])))
+            visible.push_back(i);
+}
+
+static inline void AppendMask(unsigned int mask, uint32_t first, std::vector<uint32_t>& visible)
+{
+    for (uint32_t i = first; mask; i++, mask >>= 1)
+        if (mask & 1)
+            visible.push_back(i);
+}
+
+#if CPU_X86
+// SSE2 is part of every x64 CPU, so this is the baseline
+static void CullSpheresSSE(const Frustum& frustum, const BoundingSpheres& spheres, uint32_t begin, uint32_t end, std::vector<uint32_t>& visible)
+{
+    __m128 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; p++)
+    {
+        px[p] = _mm_set1_ps(frustum.Planes[p].x);
+        py[p] = _mm_set1_ps(frustum.Planes[p].y);
+        pz[p] = _mm_set1_ps(frustum.Planes[p].z);
+        pw[p] = _mm_set1_ps(frustum.Planes[p].w);
+    }
+
+    uint32_t i = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&spheres.X[i]);
+        __m128 y = _mm_loadu_ps(&spheres.Y[i]);
+        __m128 z = _mm_loadu_ps(&spheres.Z[i]);
+        __m128 r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.Radius[i]));
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)), _mm_add_ps(_mm_mul_ps(pz[p], z), pw[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, r));
+        }
+        AppendMask((unsigned int)_mm_movemask_ps(inside), i, visible);
+    }
+    CullSpheresScalar(frustum, spheres, i, end, visible);
+}
+
+static void CullBoxesSSE(const Frustum& frustum, const BoundingBoxes& boxes, uint32_t begin, uint32_t end, std::vector<uint32_t>& visible)
+{
+    __m128 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+    for (int p = 0; p < 6; p++)
+    {
+        px[p] = _mm_set1_ps(frustum.Planes[p].x);
+        py[p] = _mm_set1_ps(frustum.Planes[p].y);
+        pz[p] = _mm_set1_ps(frustum.Planes[p].z);
+        pw[p] = _mm_set1_ps(frustum.Planes[p].w);
+        ax[p] = _mm_set1_ps(-std::fabs(frustum.Planes[p].x));
+        ay[p] = _mm_set1_ps(-std::fabs(frustum.Planes[p].y));
+        az[p] = _mm_set1_ps(-std::fabs(frustum.Planes[p].z));
+    }
+
+    uint32_t i = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 x  = _mm_loadu_ps(&boxes.CenterX[i]);
+        __m128 y  = _mm_loadu_ps(&boxes.CenterY[i]);
+        __m128 z  = _mm_loadu_ps(&boxes.CenterZ[i]);
+        __m128 ex = _mm_loadu_ps(&boxes.ExtentX[i]);
+        __m128 ey = _mm_loadu_ps(&boxes.ExtentY[i]);
+        __m128 ez = _mm_loadu_ps(&boxes.ExtentZ[i]);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)), _mm_add_ps(_mm_mul_ps(pz[p], z), pw[p]));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, r));
+        }
+        AppendMask((unsigned int)_mm_movemask_ps(inside), i, visible);
+    }
+    CullBoxesScalar(frustum, boxes, i, end, visible);
+}
+
+TARGET_AVX2 static void CullSpheresAVX2(const Frustum& frustum, const BoundingSpheres& spheres, uint32_t begin, uint32_t end, std::vector<uint32_t>& visible)
+{
+    __m256 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; p++)
+    {
+        px[p] = _mm256_set1_ps(frustum.Planes[p].x);
+        py[p] = _mm256_set1_ps(frustum.Planes[p].y);
+        pz[p] = _mm256_set1_ps(frustum.Planes[p].z);
+        pw[p] = _mm256_set1_ps(frustum.Planes[p].w);
+    }
+
+    uint32_t i = begin;
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(&spheres.X[i]);
+        __m256 y = _mm256_loadu_ps(&spheres.Y[i]);
+        __m256 z = _mm256_loadu_ps(&spheres.Z[i]);
+        __m256 r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.Radius[i]));
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 d = _mm256_fmadd_ps(px[p], x, _mm256_fmadd_ps(py[p], y, _mm256_fmadd_ps(pz[p], z, pw[p])));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, r, _CMP_GE_OQ));
+        }
+        AppendMask((unsigned int)_mm256_movemask_ps(inside), i, visible);
+    }
+    CullSpheresScalar(frustum, spheres, i, end, visible);
+}
+
+TARGET_AVX2 static void CullBoxesAVX2(const Frustum& frustum, const BoundingBoxes& boxes, uint32_t begin, uint32_t end, std::vector<uint32_t>& visible)
+{
+    __m256 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+    for (int p = 0; p < 6; p++)
+    {
+        px[p] = _mm256_set1_ps(frustum.Planes[p].x);
+        py[p] = _mm256_set1_ps(frustum.Planes[p].y);
+        pz[p] = _mm256_set1_ps(frustum.Planes[p].z);
+        pw[p] = _mm256_set1_ps(frustum.Planes[p].w);
+        ax[p] = _mm256_set1_ps(-std::fabs(frustum.Planes[p].x));
+        ay[p] = _mm256_set1_ps(-std::fabs(frustum.Planes[p].y));
+        az[p] = _mm256_set1_ps(-std::fabs(frustum.Planes[p].z));
+    }
+
+    uint32_t i = begin;
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 x  = _mm256_loadu_ps(&boxes.CenterX[i]);
+        __m256 y  = _mm256_loadu_ps(&boxes.CenterY[i]);
+        __m256 z  = _mm256_loadu_ps(&boxes.CenterZ[i]);
+        __m256 ex = _mm256_loadu_ps(&boxes.ExtentX[i]);
+        __m256 ey = _mm256_loadu_ps(&boxes.ExtentY[i]);
+        __m256 ez = _mm256_loadu_ps(&boxes.ExtentZ[i]);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 d = _mm256_fmadd_ps(px[p], x, _mm256_fmadd_ps(py[p], y, _mm256_fmadd_ps(pz[p], z, pw[p])));
+            __m256 r = _mm256_fmadd_ps(ax[p], ex, _mm256_fmadd_ps(ay[p], ey, _mm256_mul_ps(az[p], ez)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, r, _CMP_GE_OQ));
+        }
+        AppendMask((unsigned int)_mm256_movemask_ps(inside), i, visible);
+    }
+    CullBoxesScalar(frustum, boxes, i, end, visible);
+}
+#endif
+
+static SphereKernel GetSphereKernel()
+{
+    switch (CpuFeatures::GetSimdLevel())
+    {
+#if CPU_X86
+    case SimdLevel::AVX2: return CullSpheresAVX2;
+    case SimdLevel::SSE:  return CullSpheresSSE;
+#endif
+    default:              return CullSpheresScalar;
+    }
+}
+
+static BoxKernel GetBoxKernel()
+{
+    switch (CpuFeatures::GetSimdLevel())
+    {
+#if CPU_X86
+    case SimdLevel::AVX2: return CullBoxesAVX2;
+    case SimdLevel::SSE:  return CullBoxesSSE;
+#endif
+    default:              return CullBoxesScalar;
+    }
+}
+
+// Every job culls one contiguous slice into its own list, appending them in order keeps the result sorted
+template<typename Volumes, typename Kernel>
+static void CullParallel(const Frustum& frustum, const Volumes& volumes, uint32_t count, Kernel kernel, std::vector<uint32_t>& visible, unsigned int threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    uint32_t jobCount = std::min(threads, count / MinPerJob);
+    if (jobCount <= 1)
+    {
+        kernel(frustum, volumes, 0, count, visible);
+        return;
+    }
+
+    //slices are a multiple of 8 so only the last one has a scalar tail
+    uint32_t perJob = ((count + jobCount - 1) / jobCount + 7) & ~7u;
+    std::vector<std::vector<uint32_t>> results(jobCount);
+    std::vector<std::future<void>> jobs;
+    for (uint32_t j = 0; j < jobCount; j++)
+    {
+        uint32_t begin = std::min(j * perJob, count);
+        uint32_t end   = std::min(begin + perJob, count);
+        std::vector<uint32_t>& result = results[j];
+        jobs.push_back(std::async(std::launch::async, [&frustum, &volumes, kernel, begin, end, &result]() { kernel(frustum, volumes, begin, end, result); }));
+    }
+
+    size_t total = visible.size();
+    for (uint32_t j = 0; j < jobCount; j++)
+    {
+        jobs[j].wait();
+        total += results[j].size();
+    }
+
+    visible.reserve(total);
+    for (const auto& result : results)
+        visible.insert(visible.end(), result.begin(), result.end());
+}
+
+void FrustumCulling::Cull(const Frustum& frustum, const BoundingSpheres& spheres, std::vector<uint32_t>& visible, unsigned int threads)
+{
+    CullParallel(frustum, spheres, spheres.GetCount(), GetSphereKernel(), visible, threads);
+}
+
+void FrustumCulling::Cull(const Frustum& frustum, const BoundingBoxes& boxes, std::vector<uint32_t>& visible, unsigned int threads)
+{
+    CullParallel(frustum, boxes, boxes.GetCount(), GetBoxKernel(), visible, threads);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "glm/glm.hpp"
+
+// The six planes of a view volume, normals point inwards: a point p is inside when dot(plane.xyz, p) + plane.w >= 0
+struct Frustum
+{
+	glm::vec4 Planes[6]; // left, right, bottom, top, near, far
+
+	Frustum() = default;
+	// Extracted from proj * view (Gribb/Hartmann), in world space
+	Frustum(const glm::mat4& viewProjection);
+};
+
+// Bounding volumes as structure of arrays, so SIMD loads 4 or 8 of the same component at once
+struct BoundingSpheres
+{
+	std::vector<float> X, Y, Z, Radius;
+
+	void Add(const glm::vec3& center, float radius);
+	inline uint32_t GetCount() const { return (uint32_t)X.size(); }
+};
+
+struct BoundingBoxes
+{
+	std::vector<float> CenterX, CenterY, CenterZ;
+	std::vector<float> ExtentX, ExtentY, ExtentZ; // half sizes
+
+	void Add(const glm::vec3& min, const glm::vec3& max);
+	inline uint32_t GetCount() const { return (uint32_t)CenterX.size(); }
+};
+
+// Tests bounding volumes against a frustum 8 (AVX2) or 4 (SSE) at a time, as CpuFeatures::GetSimdLevel allows, and splits
+// large sets over threads. Indices of the visible volumes are appended to visible in ascending order, ready to be
+// turned into Renderer::Submit calls. Volumes touching a plane count as visible.
+class FrustumCulling
+{
+public:
+	// threads = 0 uses every hardware thread
+	static void Cull(const Frustum& frustum, const BoundingSpheres& spheres, std::vector<uint32_t>& visible, unsigned int threads = 0);
+	static void Cull(const Frustum& frustum, const BoundingBoxes& boxes, std::vector<uint32_t>& visible, unsigned int threads = 0);
+
+	static bool IsVisible(const Frustum& frustum, const glm::vec3& center, float radius);
+	static bool IsVisible(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extent);
+};
@@ -0,0 +1,262 @@
+#include "GPUCulling.h"
+
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+
+#include "Renderer.h"
+#include "Shader.h"
+
+static const unsigned int WorkGroupSize = 64; // local_size_x of Cull.shader
+
+GPUCulling::GPUCulling(uint32_t capacity)
+    : m_ObjectsDirty(false), m_Capacity(0), m_ObjectBuffer(0), m_CommandBuffer(0), m_CountBuffer(0), m_ObjectIDBuffer(0),
+      m_DrawSlots(0), m_UseGPU(false)
+{
+    ASSERT(IsSupported());
+
+    GLCall(glGenBuffers(1, &m_ObjectBuffer));
+    GLCall(glGenBuffers(1, &m_CommandBuffer));
+    GLCall(glGenBuffers(1, &m_CountBuffer));
+    GLCall(glGenBuffers(1, &m_ObjectIDBuffer));
+
+    uint32_t zero = 0;
+    GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_CountBuffer));
+    GLCall(glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t), &zero, GL_DYNAMIC_DRAW));
+    GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    Reserve(std::max(capacity, 1u));
+
+    m_CullingBlock.reset(new UniformBuffer(sizeof(CullingBlock)));
+    SetGPUCulling(true);
+}
+
+GPUCulling::~GPUCulling()
+{
+    GLCall(glDeleteBuffers(1, &m_ObjectBuffer));
+    GLCall(glDeleteBuffers(1, &m_CommandBuffer));
+    GLCall(glDeleteBuffers(1, &m_CountBuffer));
+    GLCall(glDeleteBuffers(1, &m_ObjectIDBuffer));
+}
+
+bool GPUCulling::IsSupported()
+{
+    return GLEW_ARB_shader_storage_buffer_object && GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance;
+}
+
+uint32_t GPUCulling::Add(const CullObject& object)
+{
+    m_Objects.push_back(object);
+    m_ObjectsDirty = true;
+    return (uint32_t)m_Objects.size() - 1;
+}
+
+void GPUCulling::Set(uint32_t index, const CullObject& object)
+{
+    m_Objects[index] = object;
+    m_ObjectsDirty = true;
+}
+
+void GPUCulling::SetGPUCulling(bool enabled)
+{
+    m_UseGPU = enabled && GLEW_ARB_compute_shader;
+    if (m_UseGPU && !m_CullShader)
+        m_CullShader.reset(new Shader("res/shaders/Cull.shader"));
+}
+
+void GPUCulling::AttachObjectIDs(const VertexArray& va, unsigned int location) const
+{
+    //divisor 1 starts each draw at element BaseInstance, which is the object index
+    va.Bind();
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_ObjectIDBuffer));
+    GLCall(glEnableVertexAttribArray(location));
+    GLCall(glVertexAttribIPointer(location, 1, GL_UNSIGNED_INT, sizeof(uint32_t), nullptr));
+    GLCall(glVertexAttribDivisor(location, 1));
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+void GPUCulling::Reserve(uint32_t capacity)
+{
+    if (capacity <= m_Capacity)
+        return;
+
+    uint32_t grown = std::max(capacity, m_Capacity * 2);
+
+    GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ObjectBuffer));
+    GLCall(glBufferData(GL_SHADER_STORAGE_BUFFER, grown * sizeof(CullObject), nullptr, GL_DYNAMIC_DRAW));
+    GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_CommandBuffer));
+    GLCall(glBufferData(GL_SHADER_STORAGE_BUFFER, grown * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW));
+    GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    //the IDs never change, only more of them are needed
+    std::vector<uint32_t> ids(grown);
+    std::iota(ids.begin(), ids.end(), 0u);
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_ObjectIDBuffer));
+    GLCall(glBufferData(GL_ARRAY_BUFFER, grown * sizeof(uint32_t), ids.data(), GL_STATIC_DRAW));
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+    m_Capacity = grown;
+    m_ObjectsDirty = true;
+}
+
+void GPUCulling::UploadObjects()
+{
+    if (!m_ObjectsDirty)
+        return;
+
+    Reserve((uint32_t)m_Objects.size());
+    if (!m_Objects.empty())
+    {
+        GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ObjectBuffer));
+        GLCall(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_Objects.size() * sizeof(CullObject), m_Objects.data()));
+        GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    }
+    m_ObjectsDirty = false;
+}
+
+void GPUCulling::Cull(const Frustum& frustum)
+{
+    UploadObjects();
+    uint32_t count = (uint32_t)m_Objects.size();
+
+    //a cull shader that failed to compile leaves us with the CPU path
+    if (!m_UseGPU || !m_CullShader->IsReady())
+    {
+        CullReference(frustum, m_CPUCommands);
+        m_DrawSlots = (uint32_t)m_CPUCommands.size();
+        if (m_DrawSlots)
+        {
+            GLCall(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer));
+            GLCall(glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, m_DrawSlots * sizeof(DrawElementsIndirectCommand), m_CPUCommands.data()));
+            GLCall(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+        }
+        return;
+    }
+
+    CullingBlock block = {};
+    for (int i = 0; i < 6; i++)
+        block.Planes[i] = frustum.Planes[i];
+    block.ObjectCount = count;
+    m_CullingBlock->SetData(&block, sizeof(block));
+    m_CullingBlock->BindBase(UniformBinding::Culling);
+
+    uint32_t zero = 0;
+    GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_CountBuffer));
+    GLCall(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t), &zero));
+    //without a GPU side count every slot is drawn, the ones nothing was appended to must be empty draws
+    if (!GLEW_ARB_indirect_parameters)
+    {
+        GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_CommandBuffer));
+        if (GLEW_ARB_clear_buffer_object)
+        {
+            GLCall(glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr));
+        }
+        else if (count)
+        {
+            //no clear on the GPU either, upload zeros for the slots that get drawn
+            if (m_ZeroCommands.size() < count)
+                m_ZeroCommands.resize(count);
+            GLCall(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(DrawElementsIndirectCommand), m_ZeroCommands.data()));
+        }
+    }
+    GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    GLCall(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, (unsigned int)StorageBinding::CullObjects, m_ObjectBuffer));
+    GLCall(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, (unsigned int)StorageBinding::DrawCommands, m_CommandBuffer));
+    GLCall(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, (unsigned int)StorageBinding::DrawCount, m_CountBuffer));
+
+    m_CullShader->Dispatch((count + WorkGroupSize - 1) / WorkGroupSize);
+    //the draw reads the commands and the count as indirect parameters
+    GLCall(glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT));
+
+    m_DrawSlots = count;
+}
+
+void GPUCulling::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
+{
+    if (!shader.IsReady() || m_DrawSlots == 0)
+        return;
+
+    shader.Bind();
+    shader.FlushUniforms();
+    va.Bind();
+    ib.Bind();
+    GLCall(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, (unsigned int)StorageBinding::CullObjects, m_ObjectBuffer));
+    GLCall(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer));
+
+    if (m_UseGPU && m_CullShader->IsReady() && GLEW_ARB_indirect_parameters)
+    {
+        GLCall(glBindBuffer(GL_PARAMETER_BUFFER_ARB, m_CountBuffer));
+        GLCall(glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, m_DrawSlots, 0));
+        GLCall(glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0));
+    }
+    else
+    {
+        GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, m_DrawSlots, 0));
+    }
+
+    GLCall(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+}
+
+// Keep in sync with res/shaders/Cull.shader
+void GPUCulling::CullReference(const Frustum& frustum, std::vector<DrawElementsIndirectCommand>& commands) const
+{
+    commands.clear();
+    for (uint32_t i = 0; i < m_Objects.size(); i++)
+    {
+        const CullObject& object = m_Objects[i];
+        glm::vec3 center = glm::vec3(object.Model * glm::vec4(glm::vec3(object.Sphere), 1.0f));
+        float scale = std::max(glm::length(glm::vec3(object.Model[0])), std::max(glm::length(glm::vec3(object.Model[1])), glm::length(glm::vec3(object.Model[2]))));
+
+        if (FrustumCulling::IsVisible(frustum, center, object.Sphere.w * scale))
+            commands.push_back({ object.IndexCount, 1, object.FirstIndex, object.BaseVertex, i });
+    }
+}
+
+bool GPUCulling::Validate(const Frustum& frustum) const
+{
+    if (!m_UseGPU || !m_CullShader->IsReady())
+        return true;
+
+    GLCall(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT));
+
+    uint32_t count = 0;
+    GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_CountBuffer));
+    GLCall(glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t), &count));
+
+    std::vector<DrawElementsIndirectCommand> gpu(std::min(count, m_Capacity));
+    if (!gpu.empty())
+    {
+        GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_CommandBuffer));
+        GLCall(glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, gpu.size() * sizeof(DrawElementsIndirectCommand), gpu.data()));
+    }
+    GLCall(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    //appended in whatever order the invocations ran
+    std::sort(gpu.begin(), gpu.end(), [](const DrawElementsIndirectCommand& a, const DrawElementsIndirectCommand& b)
+    {
+        return a.BaseInstance < b.BaseInstance;
+    });
+
+    std::vector<DrawElementsIndirectCommand> cpu;
+    CullReference(frustum, cpu);
+
+    if (gpu.size() != cpu.size())
+    {
+        std::cout << "GPU culling kept " << gpu.size() << " objects, the reference " << cpu.size() << std::endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < cpu.size(); i++)
+    {
+        const DrawElementsIndirectCommand& a = gpu[i];
+        const DrawElementsIndirectCommand& b = cpu[i];
+        if (a.BaseInstance != b.BaseInstance || a.Count != b.Count || a.InstanceCount != b.InstanceCount ||
+            a.FirstIndex != b.FirstIndex || a.BaseVertex != b.BaseVertex)
+        {
+            std::cout << "GPU culling command " << i << " is object " << a.BaseInstance << ", the reference has object " << b.BaseInstance << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "glm/glm.hpp"
+
+#include "FrustumCulling.h"
+#include "UniformBuffer.h"
+
+class Shader;
+class VertexArray;
+class IndexBuffer;
+
+// Shader storage binding points used by the culling and indirect draw shaders
+enum class StorageBinding : unsigned int
+{
+	CullObjects = 0, DrawCommands = 1, DrawCount = 2
+};
+
+// Layout glMultiDrawElementsIndirect reads, 20 bytes per command
+struct DrawElementsIndirectCommand
+{
+	uint32_t Count;
+	uint32_t InstanceCount;
+	uint32_t FirstIndex;
+	int32_t	 BaseVertex;
+	uint32_t BaseInstance; // the object index, instanced attributes turn it into the shader's object ID
+};
+
+// One object as the compute shader sees it, std430: 96 bytes
+struct CullObject
+{
+	glm::mat4 Model;
+	glm::vec4 Sphere;	 // local center and radius
+	uint32_t  IndexCount;
+	uint32_t  FirstIndex; // into the shared index buffer
+	int32_t	  BaseVertex;
+	uint32_t  Padding;
+};
+
+// Culls objects on the GPU and draws the survivors without the CPU seeing the result. A compute shader tests
+// each object's sphere against the frustum and appends a DrawElementsIndirectCommand for it with an atomic
+// counter; all of them are then drawn by a single glMultiDrawElementsIndirectCount, or by a plain
+// glMultiDrawElementsIndirect over every slot with culled ones zeroed when ARB_indirect_parameters is missing.
+// Without compute shaders the same test runs on the CPU (CullReference) and its commands are uploaded instead.
+// All objects share one vertex array and one index buffer, the draw shader reads its model matrix from the
+// CullObjects storage block using the per-instance object ID.
+class GPUCulling
+{
+private:
+	std::vector<CullObject>	m_Objects;
+	bool					m_ObjectsDirty;
+	uint32_t				m_Capacity;	 // objects the buffers hold
+	unsigned int			m_ObjectBuffer;
+	unsigned int			m_CommandBuffer;
+	unsigned int			m_CountBuffer;
+	unsigned int			m_ObjectIDBuffer; // 0, 1, 2... read per instance
+	uint32_t				m_DrawSlots;	  // commands the last Cull produced, or slots to walk without a count
+
+	std::unique_ptr<Shader>			m_CullShader;
+	std::unique_ptr<UniformBuffer>	m_CullingBlock;
+	bool							m_UseGPU;
+	std::vector<DrawElementsIndirectCommand> m_CPUCommands;
+	std::vector<DrawElementsIndirectCommand> m_ZeroCommands; // all zero, clears the slots without ARB_clear_buffer_object
+
+public:
+	GPUCulling(uint32_t capacity = 1024);
+	~GPUCulling();
+
+	GPUCulling(const GPUCulling&) = delete;
+	GPUCulling& operator=(const GPUCulling&) = delete;
+
+	// Storage buffers, multi draw indirect and base instance, GL 4.3. Compute shaders are optional.
+	static bool IsSupported();
+
+	// Returns the object index, which is also the BaseInstance of its command
+	uint32_t Add(const CullObject& object);
+	void	 Set(uint32_t index, const CullObject& object);
+	inline const CullObject& Get(uint32_t index) const { return m_Objects[index]; }
+	inline uint32_t GetObjectCount() const { return (uint32_t)m_Objects.size(); }
+
+	// Feeds attribute location with the object ID of each draw. Once per vertex array drawn through this.
+	void AttachObjectIDs(const VertexArray& va, unsigned int location) const;
+
+	// Writes the commands of the visible objects, on the GPU if compute shaders are available and enabled
+	void Cull(const Frustum& frustum);
+	// Draws what the last Cull left in the command buffer, with the storage blocks bound for the shader
+	void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+
+	// Same test as the compute shader, commands in object order
+	void CullReference(const Frustum& frustum, std::vector<DrawElementsIndirectCommand>& commands) const;
+	// Reads the GPU's commands back and compares them with CullReference, regardless of their order.
+	// Stalls, meant for debugging and for checking drivers; prints the first mismatch.
+	bool Validate(const Frustum& frustum) const;
+
+	inline bool IsGPUCulling() const { return m_UseGPU; }
+	// Falls back to the CPU path when set while compute shaders are missing
+	void SetGPUCulling(bool enabled);
+
+private:
+	void Reserve(uint32_t capacity);
+	void UploadObjects();
+};
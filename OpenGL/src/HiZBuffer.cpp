@@ -0,0 +1,520 @@
+#include "HiZBuffer.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "Renderer.h"
+#include "Shader.h"
+
+// Farthest of the texels under each texel of the next level. With an odd size the last row and column
+// also take the one that would be dropped, so every texel of the source is covered. Same as HiZ.shader.
+static void Downsample(const std::vector<float>& source, int width, int height, std::vector<float>& target, int targetWidth, int targetHeight)
+{
+    target.resize(targetWidth * targetHeight);
+    for (int y = 0; y < targetHeight; y++)
+    {
+        int y0 = y * 2;
+        int y1 = std::min(y == targetHeight - 1 ? height - 1 : y0 + 1, height - 1);
+        for (int x = 0; x < targetWidth; x++)
+        {
+            int x0 = x * 2;
+            int x1 = std::min(x == targetWidth - 1 ? width - 1 : x0 + 1, width - 1);
+
+            float depth = 0.0f;
+            for (int sy = y0; sy <= y1; sy++)
+                for (int sx = x0; sx <= x1; sx++)
+                    depth = std::max(depth, source[sy * width + sx]);
+            target[y * targetWidth + x] = depth;
+        }
+    }
+}
+
+HiZBuffer::HiZBuffer(int maxReadbackSize)
+    : m_Width(0), m_Height(0), m_DepthTexture(0), m_DepthFormat(0), m_PyramidTexture(0), m_PyramidLevels(0),
+      m_ReadFBO(0), m_DrawFBO(0), m_EmptyVAO(0), m_ReadbackLevel(0), m_MaxReadbackSize(maxReadbackSize),
+      m_PBO{ 0, 0 }, m_PBOFrame{ 0, 0 }, m_PBOFence{ nullptr, nullptr }, m_PBOIndex(0), m_Frame(0), m_ViewProjection(1.0f), m_HasData(false), m_Enabled(false),
+      m_Stats{ 0, 0 }, m_DebugTexture(0)
+{
+    m_DownsampleShader.reset(new Shader("res/shaders/HiZ.shader"));
+
+    GLCall(glGenVertexArrays(1, &m_EmptyVAO));
+    GLCall(glGenFramebuffers(1, &m_ReadFBO));
+    GLCall(glGenFramebuffers(1, &m_DrawFBO));
+    GLCall(glGenBuffers(2, m_PBO));
+}
+
+HiZBuffer::~HiZBuffer()
+{
+    DeleteTargets();
+    DeleteFences();
+    GLCall(glDeleteBuffers(2, m_PBO));
+    GLCall(glDeleteFramebuffers(1, &m_ReadFBO));
+    GLCall(glDeleteFramebuffers(1, &m_DrawFBO));
+    GLCall(glDeleteVertexArrays(1, &m_EmptyVAO));
+    if (m_DebugTexture)
+    {
+        GLCall(glDeleteTextures(1, &m_DebugTexture));
+    }
+}
+
+void HiZBuffer::Build(int width, int height, const glm::mat4& viewProjection)
+{
+    if (!m_DownsampleShader->IsReady() || width <= 0 || height <= 0)
+        return;
+
+    unsigned int format = GetFramebufferDepthFormat();
+    if (!format)
+        return;
+
+    if (width != m_Width || height != m_Height || format != m_DepthFormat)
+    {
+        m_DepthFormat = format;
+        CreateTargets(width, height);
+    }
+
+    int readFBO, drawFBO, viewport[4];
+    GLCall(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFBO));
+    GLCall(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFBO));
+    GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+    GLCall(bool blend = glIsEnabled(GL_BLEND) == GL_TRUE);
+    GLCall(bool depthTest = glIsEnabled(GL_DEPTH_TEST) == GL_TRUE);
+
+    //formats match, so this is a plain copy (or a resolve from a multisampled framebuffer)
+    GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_ReadFBO));
+    GLCall(glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST));
+
+    GLCall(glDisable(GL_BLEND));
+    GLCall(glDisable(GL_DEPTH_TEST));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_DrawFBO));
+    GLCall(glBindVertexArray(m_EmptyVAO));
+    GLCall(glActiveTexture(GL_TEXTURE0));
+    m_DownsampleShader->SetUniform1i("u_Source", 0);
+
+    int sourceWidth = width, sourceHeight = height;
+    for (int level = 0; level < m_PyramidLevels; level++)
+    {
+        int levelWidth	= std::max(1, sourceWidth / 2);
+        int levelHeight = std::max(1, sourceHeight / 2);
+
+        //only the level read from is visible to the sampler, so the one written to never forms a feedback loop
+        if (level == 0)
+        {
+            GLCall(glBindTexture(GL_TEXTURE_2D, m_DepthTexture));
+        }
+        else
+        {
+            GLCall(glBindTexture(GL_TEXTURE_2D, m_PyramidTexture));
+            GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1));
+            GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1));
+        }
+
+        GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_PyramidTexture, level));
+        GLCall(glViewport(0, 0, levelWidth, levelHeight));
+
+        m_DownsampleShader->SetUniform1i("u_SourceWidth", sourceWidth);
+        m_DownsampleShader->SetUniform1i("u_SourceHeight", sourceHeight);
+        m_DownsampleShader->Bind();
+        m_DownsampleShader->FlushUniforms();
+        GLCall(glDrawArrays(GL_TRIANGLES, 0, 3));
+
+        sourceWidth	 = levelWidth;
+        sourceHeight = levelHeight;
+    }
+
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_PyramidTexture));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_PyramidLevels - 1));
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+    Readback(viewProjection);
+
+    GLCall(glBindVertexArray(0));
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, readFBO));
+    GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFBO));
+    GLCall(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
+    if (blend)
+    {
+        GLCall(glEnable(GL_BLEND));
+    }
+    if (depthTest)
+    {
+        GLCall(glEnable(GL_DEPTH_TEST));
+    }
+}
+
+// Same scheme as VirtualTexture's feedback: consume the readbacks whose fence signaled, then start reading into
+// a free PBO. If the GPU is so far behind that both are still in flight, this frame's depth is skipped
+void HiZBuffer::Readback(const glm::mat4& viewProjection)
+{
+    //m_PBOIndex holds the older of two reads in flight. A zero timeout only asks, the flush bit makes sure the
+    //fence reaches the GPU at all
+    for (int i = 0; i < 2; i++)
+    {
+        int slot = (m_PBOIndex + i) % 2;
+        if (!m_PBOFence[slot])
+            continue;
+
+        GLCall(GLenum status = glClientWaitSync(m_PBOFence[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        GLCall(glDeleteSync(m_PBOFence[slot]));
+        m_PBOFence[slot] = nullptr;
+
+        GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PBO[slot]));
+        GLCall(const float* depth = (const float*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+        if (depth)
+        {
+            ProcessReadback(depth, m_PBOViewProjection[slot], m_PBOFrame[slot]);
+            GLCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+        }
+    }
+
+    if (!m_PBOFence[m_PBOIndex])
+    {
+        int width  = std::max(1, m_Width >> (m_ReadbackLevel + 1));
+        int height = std::max(1, m_Height >> (m_ReadbackLevel + 1));
+
+        GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_DrawFBO));
+        GLCall(glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_PyramidTexture, m_ReadbackLevel));
+        GLCall(glReadBuffer(GL_COLOR_ATTACHMENT0));
+
+        GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PBO[m_PBOIndex]));
+        GLCall(glReadPixels(0, 0, width, height, GL_RED, GL_FLOAT, nullptr));
+        GLCall(m_PBOFence[m_PBOIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        m_PBOViewProjection[m_PBOIndex] = viewProjection;
+        m_PBOFrame[m_PBOIndex] = m_Frame;
+        m_PBOIndex = 1 - m_PBOIndex;
+    }
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+    //a change is already in the depth of the frame it happened in, only older reads still in flight need it
+    uint32_t oldest = UINT32_MAX;
+    for (int i = 0; i < 2; i++)
+        if (m_PBOFence[i])
+            oldest = std::min(oldest, m_PBOFrame[i]);
+    m_Changes.erase(std::remove_if(m_Changes.begin(), m_Changes.end(), [oldest](const Change& change) { return change.Frame <= oldest; }), m_Changes.end());
+}
+
+void HiZBuffer::ProcessReadback(const float* depth, const glm::mat4& viewProjection, uint32_t frame)
+{
+    int width  = std::max(1, m_Width >> (m_ReadbackLevel + 1));
+    int height = std::max(1, m_Height >> (m_ReadbackLevel + 1));
+
+    m_Levels.resize(1);
+    m_Levels[0].Width  = width;
+    m_Levels[0].Height = height;
+    m_Levels[0].Depth.assign(depth, depth + width * height);
+
+    //the rest of the pyramid is a few hundred texels, cheaper to finish here than to read back
+    while (width > 1 || height > 1)
+    {
+        Level level;
+        level.Width	 = std::max(1, width / 2);
+        level.Height = std::max(1, height / 2);
+        Downsample(m_Levels.back().Depth, width, height, level.Depth, level.Width, level.Height);
+        width  = level.Width;
+        height = level.Height;
+        m_Levels.push_back(std::move(level));
+    }
+
+    m_ViewProjection = viewProjection;
+    m_HasData = true;
+
+    //what moved after this depth was drawn
+    for (const Change& change : m_Changes)
+        if (change.Frame > frame)
+            ClearToFar(change.Bounds);
+}
+
+void HiZBuffer::BeginTests(const glm::mat4& viewProjection)
+{
+    m_Stats = { 0, 0 };
+    m_Frame++;
+
+    //any camera motion can uncover what the old depth hid, so only a view matching it is culled
+    m_Enabled = m_HasData;
+    for (int c = 0; c < 4 && m_Enabled; c++)
+        for (int r = 0; r < 4; r++)
+            if (std::abs(viewProjection[c][r] - m_ViewProjection[c][r]) > 1e-5f * std::max(1.0f, std::abs(m_ViewProjection[c][r])))
+            {
+                m_Enabled = false;
+                break;
+            }
+}
+
+void HiZBuffer::Invalidate(const BoundingBox& bounds)
+{
+    m_Changes.push_back({ bounds, m_Frame });
+    ClearToFar(bounds);
+}
+
+bool HiZBuffer::IsVisible(const BoundingBox& bounds)
+{
+    m_Stats.Tested++;
+    if (!m_Enabled)
+        return true;
+
+    //crossing the near plane: nothing to compare against, off screen: frustum culling handles it
+    int x0, y0, x1, y1;
+    float nearest;
+    if (Project(bounds, x0, y0, x1, y1, nearest) != Projection::OnScreen || nearest <= 0.0f)
+        return true;
+
+    //the pyramid level where the rectangle spans at most 2x2 texels
+    size_t l = 0;
+    while ((x1 - x0 > 1 || y1 - y0 > 1) && l + 1 < m_Levels.size())
+    {
+        l++;
+        x0 = std::min(x0 >> 1, m_Levels[l].Width - 1);
+        x1 = std::min(x1 >> 1, m_Levels[l].Width - 1);
+        y0 = std::min(y0 >> 1, m_Levels[l].Height - 1);
+        y1 = std::min(y1 >> 1, m_Levels[l].Height - 1);
+    }
+
+    const Level& level = m_Levels[l];
+    float farthest = 0.0f;
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++)
+            farthest = std::max(farthest, level.Depth[y * level.Width + x]);
+
+    if (nearest > farthest)
+    {
+        m_Stats.Occluded++;
+        return false;
+    }
+    return true;
+}
+
+// Texel rectangle of bounds in m_Levels[0], projected with the matrix the depth was drawn with, and its nearest depth
+HiZBuffer::Projection HiZBuffer::Project(const BoundingBox& bounds, int& x0, int& y0, int& x1, int& y1, float& nearest) const
+{
+    glm::vec2 lo(FLT_MAX), hi(-FLT_MAX);
+    nearest = FLT_MAX;
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec4 corner((i & 1) ? bounds.Max.x : bounds.Min.x, (i & 2) ? bounds.Max.y : bounds.Min.y, (i & 4) ? bounds.Max.z : bounds.Min.z, 1.0f);
+        glm::vec4 clip = m_ViewProjection * corner;
+        //the projected rectangle would be meaningless
+        if (clip.w <= 1e-5f)
+            return Projection::Behind;
+
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        lo = glm::min(lo, glm::vec2(ndc));
+        hi = glm::max(hi, glm::vec2(ndc));
+        nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+    }
+
+    if (hi.x < -1.0f || lo.x > 1.0f || hi.y < -1.0f || lo.y > 1.0f)
+        return Projection::OffScreen;
+
+    //pixel rectangle in the depth buffer, odd sizes fold their last texel into the last one of the next level,
+    //so clamping keeps it covered
+    int shift = m_ReadbackLevel + 1;
+    x0 = std::min(glm::clamp((int)std::floor((lo.x * 0.5f + 0.5f) * m_Width), 0, m_Width - 1) >> shift, m_Levels[0].Width - 1);
+    x1 = std::min(glm::clamp((int)std::floor((hi.x * 0.5f + 0.5f) * m_Width), 0, m_Width - 1) >> shift, m_Levels[0].Width - 1);
+    y0 = std::min(glm::clamp((int)std::floor((lo.y * 0.5f + 0.5f) * m_Height), 0, m_Height - 1) >> shift, m_Levels[0].Height - 1);
+    y1 = std::min(glm::clamp((int)std::floor((hi.y * 0.5f + 0.5f) * m_Height), 0, m_Height - 1) >> shift, m_Levels[0].Height - 1);
+    return Projection::OnScreen;
+}
+
+// Pushes the texels under bounds to the far plane in every CPU level, so nothing behind them counts as hidden
+void HiZBuffer::ClearToFar(const BoundingBox& bounds)
+{
+    if (m_Levels.empty())
+        return;
+
+    int x0, y0, x1, y1;
+    float nearest;
+    Projection projection = Project(bounds, x0, y0, x1, y1, nearest);
+    if (projection == Projection::OffScreen)
+        return;
+
+    if (projection == Projection::Behind)
+    {
+        for (Level& level : m_Levels)
+            std::fill(level.Depth.begin(), level.Depth.end(), 1.0f);
+        return;
+    }
+
+    for (size_t l = 0; l < m_Levels.size(); l++)
+    {
+        Level& level = m_Levels[l];
+        if (l > 0)
+        {
+            x0 = std::min(x0 >> 1, level.Width - 1);
+            x1 = std::min(x1 >> 1, level.Width - 1);
+            y0 = std::min(y0 >> 1, level.Height - 1);
+            y1 = std::min(y1 >> 1, level.Height - 1);
+        }
+        for (int y = y0; y <= y1; y++)
+            std::fill(level.Depth.begin() + y * level.Width + x0, level.Depth.begin() + y * level.Width + x1 + 1, 1.0f);
+    }
+}
+
+unsigned int HiZBuffer::GetDebugTexture(int level, int& width, int& height)
+{
+    width = height = 0;
+    if (level < 0 || level >= (int)m_Levels.size())
+        return 0;
+
+    const Level& source = m_Levels[level];
+    width  = source.Width;
+    height = source.Height;
+
+    //depth crowds near 1 with a perspective projection, stretch what is there to the full range
+    auto range = std::minmax_element(source.Depth.begin(), source.Depth.end());
+    float minDepth = *range.first;
+    float scale = *range.second > minDepth ? 1.0f / (*range.second - minDepth) : 0.0f;
+
+    std::vector<unsigned char> pixels(width * height * 4);
+    for (int i = 0; i < width * height; i++)
+    {
+        unsigned char value = (unsigned char)((source.Depth[i] - minDepth) * scale * 255.0f);
+        pixels[i * 4 + 0] = value;
+        pixels[i * 4 + 1] = value;
+        pixels[i * 4 + 2] = value;
+        pixels[i * 4 + 3] = 255;
+    }
+
+    if (!m_DebugTexture)
+    {
+        GLCall(glGenTextures(1, &m_DebugTexture));
+        GLCall(glBindTexture(GL_TEXTURE_2D, m_DebugTexture));
+        GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+        GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    }
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_DebugTexture));
+    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+    return m_DebugTexture;
+}
+
+void HiZBuffer::CreateTargets(int width, int height)
+{
+    DeleteTargets();
+    m_Width	 = width;
+    m_Height = height;
+
+    bool stencil = m_DepthFormat == GL_DEPTH24_STENCIL8 || m_DepthFormat == GL_DEPTH32F_STENCIL8;
+    GLCall(glGenTextures(1, &m_DepthTexture));
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_DepthTexture));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
+    if (m_DepthFormat == GL_DEPTH24_STENCIL8)
+    {
+        GLCall(glTexImage2D(GL_TEXTURE_2D, 0, m_DepthFormat, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr));
+    }
+    else if (m_DepthFormat == GL_DEPTH32F_STENCIL8)
+    {
+        GLCall(glTexImage2D(GL_TEXTURE_2D, 0, m_DepthFormat, width, height, 0, GL_DEPTH_STENCIL, GL_FLOAT_32_UNSIGNED_INT_24_8_REV, nullptr));
+    }
+    else
+    {
+        GLCall(glTexImage2D(GL_TEXTURE_2D, 0, m_DepthFormat, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr));
+    }
+
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_ReadFBO));
+    GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_DepthTexture, 0));
+    GLCall(glDrawBuffer(GL_NONE));
+    GLCall(glReadBuffer(GL_NONE));
+
+    //every level down to 1x1, the first one no larger than m_MaxReadbackSize is read back
+    m_PyramidLevels = 0;
+    m_ReadbackLevel = -1;
+    GLCall(glGenTextures(1, &m_PyramidTexture));
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_PyramidTexture));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    int levelWidth = width, levelHeight = height;
+    do
+    {
+        levelWidth	= std::max(1, levelWidth / 2);
+        levelHeight = std::max(1, levelHeight / 2);
+        GLCall(glTexImage2D(GL_TEXTURE_2D, m_PyramidLevels, GL_R32F, levelWidth, levelHeight, 0, GL_RED, GL_FLOAT, nullptr));
+        if (m_ReadbackLevel < 0 && levelWidth <= m_MaxReadbackSize && levelHeight <= m_MaxReadbackSize)
+            m_ReadbackLevel = m_PyramidLevels;
+        m_PyramidLevels++;
+    } while (levelWidth > 1 || levelHeight > 1);
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_PyramidLevels - 1));
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+    int readbackWidth  = std::max(1, width >> (m_ReadbackLevel + 1));
+    int readbackHeight = std::max(1, height >> (m_ReadbackLevel + 1));
+    for (unsigned int pbo : m_PBO)
+    {
+        GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo));
+        GLCall(glBufferData(GL_PIXEL_PACK_BUFFER, readbackWidth * readbackHeight * sizeof(float), nullptr, GL_STREAM_READ));
+    }
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+    //whatever was read back belongs to the old size
+    DeleteFences();
+    m_Changes.clear();
+    m_Levels.clear();
+    m_HasData = false;
+}
+
+void HiZBuffer::DeleteTargets()
+{
+    if (m_DepthTexture)
+    {
+        GLCall(glDeleteTextures(1, &m_DepthTexture));
+    }
+    if (m_PyramidTexture)
+    {
+        GLCall(glDeleteTextures(1, &m_PyramidTexture));
+    }
+    m_DepthTexture = m_PyramidTexture = 0;
+}
+
+void HiZBuffer::DeleteFences()
+{
+    for (GLsync& fence : m_PBOFence)
+    {
+        if (fence)
+        {
+            GLCall(glDeleteSync(fence));
+        }
+        fence = nullptr;
+    }
+}
+
+// Internal format of the depth buffer bound for reading, blits between depth buffers need identical formats.
+// 0 if it has no depth.
+unsigned int HiZBuffer::GetFramebufferDepthFormat() const
+{
+    int fbo;
+    GLCall(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &fbo));
+    GLenum depthAttachment	 = fbo ? GL_DEPTH_ATTACHMENT : GL_DEPTH;
+    GLenum stencilAttachment = fbo ? GL_STENCIL_ATTACHMENT : GL_STENCIL;
+
+    int type;
+    GLCall(glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, depthAttachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type));
+    if (type == GL_NONE)
+        return 0;
+
+    int depthBits, componentType, stencilBits = 0;
+    GLCall(glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, depthAttachment, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthBits));
+    GLCall(glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, depthAttachment, GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE, &componentType));
+    GLCall(glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, stencilAttachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type));
+    if (type != GL_NONE)
+    {
+        GLCall(glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, stencilAttachment, GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencilBits));
+    }
+
+    if (depthBits == 0)
+        return 0;
+    if (componentType == GL_FLOAT)
+        return stencilBits ? GL_DEPTH32F_STENCIL8 : GL_DEPTH_COMPONENT32F;
+    if (stencilBits)
+        return GL_DEPTH24_STENCIL8;
+    if (depthBits == 16)
+        return GL_DEPTH_COMPONENT16;
+    return depthBits == 32 ? GL_DEPTH_COMPONENT32 : GL_DEPTH_COMPONENT24;
+}
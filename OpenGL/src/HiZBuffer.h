@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+#include "glm/glm.hpp"
+
+#include "BVH.h"
+
+class Shader;
+
+// Counted since the last BeginTests
+struct OcclusionStats
+{
+	unsigned int Tested;
+	unsigned int Occluded;
+};
+
+// Hierarchical Z occlusion culling against the previous frame's depth.
+// Build downsamples the depth buffer into a pyramid on the GPU, every texel holding the farthest depth under it,
+// and reads one coarse level back through a PBO; the result arrives a frame later and the levels above it are
+// finished on the CPU. IsVisible projects a box with the matrix that depth was rendered with and compares its
+// nearest point against the farthest depth of the few texels covering it.
+//
+// Everything is considered visible while it can't be proven hidden: before the first readback, after a resize,
+// while the view projection differs from the one the depth belongs to (the camera moved and the old depth says
+// nothing about what it uncovered), and for boxes reaching behind the camera. The depth is a few frames old, so
+// whatever moved or disappeared since is reported with Invalidate: its old bounds stop hiding anything until a
+// depth drawn after the change arrives.
+//
+// Per frame:
+//   hiZ.BeginTests(viewProjection);  Invalidate old bounds;  cull with IsVisible;  draw;  hiZ.Build(width, height, viewProjection)
+class HiZBuffer
+{
+private:
+	struct Level
+	{
+		int				   Width, Height;
+		std::vector<float> Depth;
+	};
+
+	struct Change
+	{
+		BoundingBox Bounds;
+		uint32_t	Frame;
+	};
+
+	enum class Projection
+	{
+		Behind,		// a corner is behind the camera
+		OffScreen,
+		OnScreen
+	};
+
+	int			 m_Width, m_Height; // of the depth buffer
+	unsigned int m_DepthTexture;	// copy of the framebuffer's depth
+	unsigned int m_DepthFormat;
+	unsigned int m_PyramidTexture;	// R32F, level 0 is half the depth's size
+	int			 m_PyramidLevels;
+	unsigned int m_ReadFBO, m_DrawFBO;
+	unsigned int m_EmptyVAO;		// the downsample pass makes its triangle from gl_VertexID
+	std::unique_ptr<Shader> m_DownsampleShader;
+
+	// readback of pyramid level m_ReadbackLevel, double buffered. A PBO is only mapped once its fence signaled,
+	// so mapping never waits on the GPU
+	int			 m_ReadbackLevel;
+	int			 m_MaxReadbackSize;
+	unsigned int m_PBO[2];
+	glm::mat4	 m_PBOViewProjection[2];
+	uint32_t	 m_PBOFrame[2];
+	GLsync		 m_PBOFence[2]; // readback in flight, nullptr if the PBO is free
+	int			 m_PBOIndex;
+
+	uint32_t			m_Frame;   // counted by BeginTests
+	std::vector<Change> m_Changes; // newer than some depth still to come, applied to it when it arrives
+
+	// CPU pyramid from the last readback, m_Levels[0] is pyramid level m_ReadbackLevel
+	std::vector<Level> m_Levels;
+	glm::mat4		   m_ViewProjection; // what m_Levels was rendered with
+	bool			   m_HasData;
+	bool			   m_Enabled;		 // the current frame can be tested against m_Levels
+	OcclusionStats	   m_Stats;
+
+	unsigned int m_DebugTexture;
+
+public:
+	// maxReadbackSize: the level read back is the first one no larger than this in both directions
+	HiZBuffer(int maxReadbackSize = 128);
+	~HiZBuffer();
+
+	HiZBuffer(const HiZBuffer&) = delete;
+	HiZBuffer& operator=(const HiZBuffer&) = delete;
+
+	// Takes the depth of the framebuffer bound for reading, viewProjection is what the frame was drawn with
+	void Build(int width, int height, const glm::mat4& viewProjection);
+
+	// Decides whether this frame can be culled at all, call before the IsVisible calls
+	void BeginTests(const glm::mat4& viewProjection);
+	// Something drawn inside bounds moved away or is gone this frame. Call between BeginTests and the IsVisible
+	// calls, with the bounds it had last frame.
+	void Invalidate(const BoundingBox& bounds);
+	// False only if the box is certainly behind what was drawn last frame
+	bool IsVisible(const BoundingBox& bounds);
+
+	inline bool IsEnabled() const { return m_Enabled; }
+	inline const OcclusionStats& GetStats() const { return m_Stats; }
+
+	inline int GetLevelCount() const { return (int)m_Levels.size(); }
+	// Grayscale view of a CPU level for ImGui::Image, near is dark. Rebuilt on every call.
+	unsigned int GetDebugTexture(int level, int& width, int& height);
+
+private:
+	void CreateTargets(int width, int height);
+	void DeleteTargets();
+	void DeleteFences();
+	void Readback(const glm::mat4& viewProjection);
+	void ProcessReadback(const float* depth, const glm::mat4& viewProjection, uint32_t frame);
+	Projection Project(const BoundingBox& bounds, int& x0, int& y0, int& x1, int& y1, float& nearest) const;
+	void ClearToFar(const BoundingBox& bounds);
+	unsigned int GetFramebufferDepthFormat() const;
+};
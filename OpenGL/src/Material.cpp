@@ -0,0 +1,129 @@
+#include "Material.h"
+
+#include <algorithm>
+
+#include "MaterialInstance.h"
+#include "Texture.h"
+
+uint32_t Material::s_NextID = 1;
+
+Material::Material(Shader& shader)
+    : m_ID(s_NextID++), m_Shader(shader), m_Alignment(256)
+{
+    int alignment;
+    GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    m_Alignment = alignment > 0 ? (unsigned int)alignment : 256;
+}
+
+Material::~Material()
+{
+    //instances hold a reference to us, they have to be gone first
+    ASSERT(std::none_of(m_Instances.begin(), m_Instances.end(), [](MaterialInstance* instance) { return instance != nullptr; }));
+}
+
+void Material::AddTexture(const std::string& name, const Texture* texture)
+{
+    ASSERT(m_Instances.empty());
+    m_Textures.push_back({ name, texture });
+}
+
+void Material::Upload()
+{
+    if (m_DirtySlots.empty())
+        return;
+
+    unsigned int slotSize = GetSlotSize();
+    for (unsigned int slot : m_DirtySlots)
+    {
+        MaterialInstance* instance = m_Instances[slot];
+        m_Buffer->SetData(instance->m_Block.data(), GetBlockSize(), slot * slotSize);
+        instance->m_Dirty = false;
+    }
+    m_DirtySlots.clear();
+}
+
+void Material::Bind() const
+{
+    //with shadowed uniforms these only reach GL the first time
+    for (unsigned int i = 0; i < m_Textures.size(); i++)
+        m_Shader.SetUniform1i(m_Textures[i].Name, (int)i);
+}
+
+const MaterialParameter* Material::FindParameter(uint32_t hash) const
+{
+    for (const MaterialParameter& parameter : m_Parameters)
+        if (parameter.Hash == hash)
+            return &parameter;
+    return nullptr;
+}
+
+int Material::FindTexture(uint32_t hash) const
+{
+    for (unsigned int i = 0; i < m_Textures.size(); i++)
+        if (UniformHash(m_Textures[i].Name.c_str()) == hash)
+            return (int)i;
+    return -1;
+}
+
+unsigned int Material::Register(MaterialInstance& instance)
+{
+    unsigned int slot;
+    if (!m_FreeSlots.empty())
+    {
+        slot = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+        m_Instances[slot] = &instance;
+    }
+    else
+    {
+        slot = (unsigned int)m_Instances.size();
+        m_Instances.push_back(&instance);
+    }
+
+    unsigned int slotSize = GetSlotSize();
+    if (slotSize && (!m_Buffer || m_Buffer->GetSize() < m_Instances.size() * slotSize))
+    {
+        //grow by doubling, the new buffer starts empty so every live instance uploads again
+        unsigned int capacity = std::max(16u, (unsigned int)m_Instances.size() * 2);
+        m_Buffer = std::make_unique<UniformBuffer>(capacity * slotSize);
+
+        m_DirtySlots.clear();
+        for (MaterialInstance* other : m_Instances)
+            if (other)
+                other->m_Dirty = false;
+        for (unsigned int i = 0; i < m_Instances.size(); i++)
+            if (m_Instances[i])
+                MarkDirty(i);
+    }
+
+    return slot;
+}
+
+void Material::Unregister(unsigned int slot)
+{
+    m_Instances[slot] = nullptr;
+    m_FreeSlots.push_back(slot);
+    m_DirtySlots.erase(std::remove(m_DirtySlots.begin(), m_DirtySlots.end(), slot), m_DirtySlots.end());
+}
+
+void Material::MarkDirty(unsigned int slot)
+{
+    MaterialInstance* instance = m_Instances[slot];
+    if (instance->m_Dirty || !GetSlotSize())
+        return;
+
+    instance->m_Dirty = true;
+    m_DirtySlots.push_back(slot);
+}
+
+unsigned int Material::GetSlotSize() const
+{
+    //every slot starts on a valid glBindBufferRange offset
+    return (GetBlockSize() + m_Alignment - 1) / m_Alignment * m_Alignment;
+}
+
+void Material::BindSlot(unsigned int slot) const
+{
+    if (m_Buffer)
+        m_Buffer->BindRange(UniformBinding::Material, slot * GetSlotSize(), GetBlockSize());
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+
+#include "Renderer.h"
+#include "Shader.h"
+#include "UniformBuffer.h"
+#include "UniformBufferLayout.h"
+
+class Texture;
+class MaterialInstance;
+
+// A value in the material's "Material" uniform block
+struct MaterialParameter
+{
+	uint32_t	 Hash;
+	unsigned int Offset;
+	unsigned int Size;
+	std::string	 Name;
+};
+
+// A sampler uniform, texture i is bound to slot i
+struct MaterialTexture
+{
+	std::string		Name;
+	const Texture*	Default;
+};
+
+// A shader plus the defaults of its parameters and textures. Every MaterialInstance of it gets an aligned slot
+// in one uniform buffer holding its copy of the parameter block; only slots of changed instances are uploaded.
+// Declare all parameters before creating instances, the material must outlive them.
+class Material
+{
+private:
+	uint32_t						m_ID;
+	Shader&							m_Shader;
+	UniformBufferLayout				m_Layout;
+	std::vector<MaterialParameter>	m_Parameters;
+	std::vector<unsigned char>		m_Defaults;
+	std::vector<MaterialTexture>	m_Textures;
+
+	std::unique_ptr<UniformBuffer>	m_Buffer;
+	unsigned int					m_Alignment; // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	std::vector<MaterialInstance*>	m_Instances; // by slot, nullptr if free
+	std::vector<unsigned int>		m_FreeSlots;
+	std::vector<unsigned int>		m_DirtySlots;
+
+	static uint32_t s_NextID;
+
+public:
+	Material(Shader& shader);
+	~Material();
+
+	Material(const Material&) = delete;
+	Material& operator=(const Material&) = delete;
+
+	// Appended to the block in std140 order, so declare them in the order the shader does
+	template<typename T>
+	void AddParameter(const std::string& name, const T& value)
+	{
+		ASSERT(m_Instances.empty());
+
+		unsigned int offset = m_Layout.Push<T>();
+		m_Parameters.push_back({ UniformHash(name.c_str()), offset, (unsigned int)sizeof(T), name });
+		m_Defaults.resize(m_Layout.GetSize());
+		std::memcpy(&m_Defaults[offset], &value, sizeof(T));
+	}
+
+	void AddTexture(const std::string& name, const Texture* texture);
+
+	// Uploads the blocks of instances changed since the last call
+	void Upload();
+	// Points the samplers at their slots, the shader must be bound
+	void Bind() const;
+
+	inline uint32_t GetID() const { return m_ID; }
+	inline Shader& GetShader() const { return m_Shader; }
+	inline unsigned int GetBlockSize() const { return m_Layout.GetSize(); }
+	inline const std::vector<MaterialTexture>& GetTextures() const { return m_Textures; }
+
+	const MaterialParameter* FindParameter(uint32_t hash) const;
+	int FindTexture(uint32_t hash) const;
+
+private:
+	friend class MaterialInstance;
+
+	unsigned int Register(MaterialInstance& instance);
+	void		 Unregister(unsigned int slot);
+	void		 MarkDirty(unsigned int slot);
+	unsigned int GetSlotSize() const;
+	void		 BindSlot(unsigned int slot) const;
+};
@@ -0,0 +1,64 @@
+#include "MaterialInstance.h"
+
+#include <iostream>
+
+#include "Texture.h"
+
+uint32_t MaterialInstance::s_NextID = 1;
+
+MaterialInstance::MaterialInstance(Material& material)
+    : m_ID(s_NextID++), m_Material(material), m_Slot(0), m_Block(material.m_Defaults),
+      m_Textures(material.GetTextures().size(), nullptr), m_Dirty(false)
+{
+    m_Slot = m_Material.Register(*this);
+    //the slot's old contents belong to whoever had it before
+    m_Material.MarkDirty(m_Slot);
+}
+
+MaterialInstance::~MaterialInstance()
+{
+    m_Material.Unregister(m_Slot);
+}
+
+void MaterialInstance::SetData(UniformID name, const void* data, unsigned int size)
+{
+    const MaterialParameter* parameter = m_Material.FindParameter(name.Hash);
+    if (!parameter)
+    {
+        std::cout << "Warning: material parameter " << name.Name << " doesn't exist!" << std::endl;
+        return;
+    }
+
+    ASSERT(size == parameter->Size);
+    unsigned char* value = &m_Block[parameter->Offset];
+    if (std::memcmp(value, data, size) == 0)
+        return;
+
+    std::memcpy(value, data, size);
+    m_Material.MarkDirty(m_Slot);
+}
+
+void MaterialInstance::SetTexture(UniformID name, const Texture* texture)
+{
+    int index = m_Material.FindTexture(name.Hash);
+    if (index == -1)
+    {
+        std::cout << "Warning: material texture " << name.Name << " doesn't exist!" << std::endl;
+        return;
+    }
+
+    m_Textures[index] = texture;
+}
+
+void MaterialInstance::Bind() const
+{
+    m_Material.BindSlot(m_Slot);
+
+    const std::vector<MaterialTexture>& textures = m_Material.GetTextures();
+    for (unsigned int i = 0; i < textures.size(); i++)
+    {
+        const Texture* texture = m_Textures[i] ? m_Textures[i] : textures[i].Default;
+        if (texture)
+            texture->Bind(i);
+    }
+}
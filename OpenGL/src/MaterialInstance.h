@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Material.h"
+
+// Overrides of a Material's parameters and textures. The ID never changes and is never reused, the renderer
+// sorts draws by it. Setting a value that is already there doesn't mark the instance for upload.
+class MaterialInstance
+{
+private:
+	uint32_t					m_ID;
+	Material&					m_Material;
+	unsigned int				m_Slot;
+	std::vector<unsigned char>	m_Block;
+	std::vector<const Texture*>	m_Textures; // per material texture, nullptr uses the default
+	bool						m_Dirty;
+
+	static uint32_t s_NextID;
+
+public:
+	MaterialInstance(Material& material);
+	~MaterialInstance();
+
+	MaterialInstance(const MaterialInstance&) = delete;
+	MaterialInstance& operator=(const MaterialInstance&) = delete;
+
+	template<typename T>
+	void Set(UniformID name, const T& value) { SetData(name, &value, sizeof(T)); }
+
+	// nullptr goes back to the material's texture
+	void SetTexture(UniformID name, const Texture* texture);
+
+	// Selects this instance's block and binds its textures, Material::Bind must have run for the material
+	void Bind() const;
+
+	inline uint32_t GetID() const { return m_ID; }
+	inline Material& GetMaterial() const { return m_Material; }
+
+private:
+	friend class Material;
+
+	void SetData(UniformID name, const void* data, unsigned int size);
+};
@@ -0,0 +1,40 @@
+#include "MeshLOD.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "MeshSimplifier.h"
+
+MeshLOD::MeshLOD(const float* positions, uint32_t vertexCount, unsigned int stride, const unsigned int* indices, unsigned int indexCount,
+                 unsigned int maxLevels, float reduction)
+{
+    std::vector<unsigned int> chain(indices, indices + indexCount);
+    m_Levels.push_back({ 0, indexCount, 0.0f });
+
+    //each level is simplified from the previous one, the errors add up so the total stays an upper bound
+    std::vector<unsigned int> level(indices, indices + indexCount);
+    while (m_Levels.size() < maxLevels)
+    {
+        uint32_t target = (uint32_t)(level.size() * reduction) / 3 * 3;
+        float error;
+        std::vector<unsigned int> next = MeshSimplifier::Simplify(positions, vertexCount, stride, level.data(), (uint32_t)level.size(), target, FLT_MAX, error);
+        if (next.empty() || next.size() > level.size() * 0.9f)
+            break;
+
+        m_Levels.push_back({ (unsigned int)chain.size(), (unsigned int)next.size(), m_Levels.back().Error + error });
+        chain.insert(chain.end(), next.begin(), next.end());
+        level.swap(next);
+    }
+
+    m_IndexBuffer.reset(new IndexBuffer(chain.data(), (unsigned int)chain.size()));
+}
+
+unsigned int MeshLOD::SelectLevel(unsigned int current, float pixelsPerUnit, float threshold, float hysteresis) const
+{
+    unsigned int level = std::min(current, GetLevelCount() - 1);
+    while (level > 0 && m_Levels[level].Error * pixelsPerUnit > threshold)
+        level--;
+    while (level + 1 < GetLevelCount() && m_Levels[level + 1].Error * pixelsPerUnit <= threshold * (1.0f - hysteresis))
+        level++;
+    return level;
+}
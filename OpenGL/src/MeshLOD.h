@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "IndexBuffer.h"
+
+struct LODLevel
+{
+	unsigned int FirstIndex;
+	unsigned int IndexCount;
+	float		 Error; // in model units, how far the surface may be from the full mesh
+};
+
+// Level of detail chain of one mesh, built with MeshSimplifier: each level has about half the triangles of the
+// previous one and all of them share one index buffer over the original vertices, so switching level only changes
+// the range that is drawn. Level 0 is the full mesh.
+class MeshLOD
+{
+private:
+	std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	std::vector<LODLevel>		 m_Levels;
+
+public:
+	// positions: x, y, z at the start of every vertex, stride is in floats. Stops early when a level can't get
+	// meaningfully smaller, borders and seams limit how far a mesh goes down.
+	MeshLOD(const float* positions, uint32_t vertexCount, unsigned int stride, const unsigned int* indices, unsigned int indexCount,
+			unsigned int maxLevels = 6, float reduction = 0.5f);
+
+	inline const IndexBuffer&			GetIndexBuffer() const { return *m_IndexBuffer; }
+	inline const std::vector<LODLevel>& GetLevels()		 const { return m_Levels; }
+	inline unsigned int					GetLevelCount()	 const { return (unsigned int)m_Levels.size(); }
+
+	// Coarsest level whose error covers at most threshold pixels. pixelsPerUnit is the size on screen of one
+	// model unit at the mesh's distance. Going coarser than current needs a margin of hysteresis (0..1) below the
+	// threshold, so meshes near a switching distance don't flicker between two levels.
+	unsigned int SelectLevel(unsigned int current, float pixelsPerUnit, float threshold, float hysteresis) const;
+};
@@ -0,0 +1,235 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <cfloat>
+#include <cmath>
+
+#include "glm/glm.hpp"
+
+// Sum of squared distances to a set of planes, the symmetric 4x4 matrix stored as its upper triangle
+struct Quadric
+{
+    double A00, A01, A02, A03;
+    double A11, A12, A13;
+    double A22, A23;
+    double A33;
+
+    void AddPlane(const glm::dvec4& p)
+    {
+        A00 += p.x * p.x; A01 += p.x * p.y; A02 += p.x * p.z; A03 += p.x * p.w;
+        A11 += p.y * p.y; A12 += p.y * p.z; A13 += p.y * p.w;
+        A22 += p.z * p.z; A23 += p.z * p.w;
+        A33 += p.w * p.w;
+    }
+
+    void Add(const Quadric& q)
+    {
+        A00 += q.A00; A01 += q.A01; A02 += q.A02; A03 += q.A03;
+        A11 += q.A11; A12 += q.A12; A13 += q.A13;
+        A22 += q.A22; A23 += q.A23;
+        A33 += q.A33;
+    }
+
+    double Evaluate(const glm::dvec3& v) const
+    {
+        return A00 * v.x * v.x + 2.0 * A01 * v.x * v.y + 2.0 * A02 * v.x * v.z + 2.0 * A03 * v.x
+             + A11 * v.y * v.y + 2.0 * A12 * v.y * v.z + 2.0 * A13 * v.y
+             + A22 * v.z * v.z + 2.0 * A23 * v.z
+             + A33;
+    }
+};
+
+struct Collapse
+{
+    uint32_t From;
+    uint32_t To;
+    double   Cost;
+};
+
+static uint32_t Resolve(std::vector<uint32_t>& remap, uint32_t v)
+{
+    while (remap[v] != v)
+    {
+        remap[v] = remap[remap[v]];
+        v = remap[v];
+    }
+    return v;
+}
+
+static uint64_t EdgeKey(uint32_t a, uint32_t b)
+{
+    return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+std::vector<unsigned int> MeshSimplifier::Simplify(const float* positions, uint32_t vertexCount, unsigned int stride,
+                                                   const unsigned int* indices, uint32_t indexCount, uint32_t targetIndexCount,
+                                                   float maxError, float& error)
+{
+    error = 0.0f;
+    std::vector<unsigned int> result(indices, indices + indexCount);
+
+    std::vector<glm::dvec3> points(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        points[v] = glm::dvec3(positions[v * stride], positions[v * stride + 1], positions[v * stride + 2]);
+
+    //seams: more than one vertex at the same position, collapsing one side would tear the other
+    std::vector<uint8_t> locked(vertexCount, 0);
+    std::vector<uint32_t> byPosition(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        byPosition[v] = v;
+    auto less = [&points](uint32_t a, uint32_t b)
+    {
+        const glm::dvec3& p = points[a];
+        const glm::dvec3& q = points[b];
+        return p.x < q.x || (p.x == q.x && (p.y < q.y || (p.y == q.y && p.z < q.z)));
+    };
+    std::sort(byPosition.begin(), byPosition.end(), less);
+    for (uint32_t i = 1; i < vertexCount; i++)
+    {
+        if (points[byPosition[i]] == points[byPosition[i - 1]])
+            locked[byPosition[i]] = locked[byPosition[i - 1]] = 1;
+    }
+
+    //borders: edges used by a single triangle
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+    for (uint32_t i = 0; i < indexCount; i += 3)
+        for (int e = 0; e < 3; e++)
+            edgeUses[EdgeKey(indices[i + e], indices[i + (e + 1) % 3])]++;
+    for (const auto& edge : edgeUses)
+    {
+        if (edge.second == 1)
+            locked[edge.first >> 32] = locked[edge.first & 0xFFFFFFFF] = 1;
+    }
+
+    std::vector<Quadric> quadrics(vertexCount, Quadric{});
+    for (uint32_t i = 0; i < indexCount; i += 3)
+    {
+        const glm::dvec3& p0 = points[indices[i]];
+        glm::dvec3 normal = glm::cross(points[indices[i + 1]] - p0, points[indices[i + 2]] - p0);
+        double length = glm::length(normal);
+        if (length == 0.0)
+            continue;
+        normal /= length;
+        glm::dvec4 plane(normal, -glm::dot(normal, p0));
+        for (int c = 0; c < 3; c++)
+            quadrics[indices[i + c]].AddPlane(plane);
+    }
+
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+    std::vector<uint32_t> vertexTriangles;
+    std::vector<Collapse> collapses;
+    double maxCost = (double)maxError * maxError;
+    double worst = 0.0;
+
+    //every pass collapses a batch of independent edges, cheapest first, then rebuilds the index list
+    while (result.size() > targetIndexCount)
+    {
+        uint32_t triangleCount = (uint32_t)result.size() / 3;
+        for (uint32_t v = 0; v < vertexCount; v++)
+            remap[v] = v;
+        std::fill(touched.begin(), touched.end(), 0);
+
+        //triangles around each vertex
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (unsigned int index : result)
+            triangleOffsets[index + 1]++;
+        for (uint32_t v = 0; v < vertexCount; v++)
+            triangleOffsets[v + 1] += triangleOffsets[v];
+        vertexTriangles.resize(result.size());
+        std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (uint32_t i = 0; i < result.size(); i++)
+            vertexTriangles[fill[result[i]]++] = i / 3;
+
+        collapses.clear();
+        for (uint32_t i = 0; i < result.size(); i += 3)
+        {
+            for (int e = 0; e < 3; e++)
+            {
+                //interior edges appear once in each direction, border edges are locked on both ends anyway
+                uint32_t a = result[i + e], b = result[i + (e + 1) % 3];
+                if (a < b && (!locked[a] || !locked[b]))
+                {
+                    Quadric q = quadrics[a];
+                    q.Add(quadrics[b]);
+                    double toB = locked[a] ? DBL_MAX : q.Evaluate(points[b]);
+                    double toA = locked[b] ? DBL_MAX : q.Evaluate(points[a]);
+                    if (toB <= toA)
+                        collapses.push_back({ a, b, std::max(0.0, toB) });
+                    else
+                        collapses.push_back({ b, a, std::max(0.0, toA) });
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y)
+        {
+            return x.Cost < y.Cost || (x.Cost == y.Cost && EdgeKey(x.From, x.To) < EdgeKey(y.From, y.To));
+        });
+
+        uint32_t collapsed = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            if (triangleCount * 3 <= targetIndexCount || collapse.Cost > maxCost)
+                break;
+            if (touched[collapse.From] || touched[collapse.To])
+                continue;
+
+            //reject collapses that would flip a remaining triangle around From
+            bool flips = false;
+            uint32_t removed = 0;
+            for (uint32_t t = triangleOffsets[collapse.From]; t < triangleOffsets[collapse.From + 1] && !flips; t++)
+            {
+                uint32_t triangle = vertexTriangles[t] * 3;
+                uint32_t v[3];
+                for (int c = 0; c < 3; c++)
+                    v[c] = Resolve(remap, result[triangle + c]);
+                if (v[0] == v[1] || v[1] == v[2] || v[2] == v[0])
+                    continue;
+                if (v[0] == collapse.To || v[1] == collapse.To || v[2] == collapse.To)
+                {
+                    removed++;
+                    continue;
+                }
+
+                glm::dvec3 before = glm::cross(points[v[1]] - points[v[0]], points[v[2]] - points[v[0]]);
+                for (int c = 0; c < 3; c++)
+                {
+                    if (v[c] == collapse.From)
+                        v[c] = collapse.To;
+                }
+                glm::dvec3 after = glm::cross(points[v[1]] - points[v[0]], points[v[2]] - points[v[0]]);
+                //turning by more than 60 degrees counts too, a few of those in a row turn it over just the same
+                flips = glm::dot(before, after) <= 0.5 * glm::length(before) * glm::length(after);
+            }
+            if (flips)
+                continue;
+
+            remap[collapse.From] = collapse.To;
+            quadrics[collapse.To].Add(quadrics[collapse.From]);
+            touched[collapse.From] = touched[collapse.To] = 1;
+            triangleCount -= removed;
+            worst = std::max(worst, collapse.Cost);
+            collapsed++;
+        }
+
+        if (collapsed == 0)
+            break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            uint32_t a = Resolve(remap, result[i]), b = Resolve(remap, result[i + 1]), c = Resolve(remap, result[i + 2]);
+            if (a == b || b == c || c == a)
+                continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    error = (float)std::sqrt(worst);
+    return result;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+// Quadric error edge collapse (Garland/Heckbert) that only rewrites indices: a vertex is collapsed onto one of its
+// neighbours instead of a new position, so every level of detail keeps using the original vertex buffer.
+// Vertices on open borders and on attribute seams (several vertices at the same position) never move, which keeps
+// holes and UV seams from opening. CPU only, meant for load time or an offline tool.
+class MeshSimplifier
+{
+public:
+	// positions: x, y, z at the start of every vertex, stride is in floats. Collapses cheapest edges first until
+	// at most targetIndexCount indices are left or the next collapse would cost more than maxError. error receives
+	// the largest collapse error, roughly the distance in model units the surface moved.
+	static std::vector<unsigned int> Simplify(const float* positions, uint32_t vertexCount, unsigned int stride,
+											  const unsigned int* indices, uint32_t indexCount, uint32_t targetIndexCount,
+											  float maxError, float& error);
+};
@@ -0,0 +1,210 @@
+#include "ObjectPicker.h"
+
+#include <iostream>
+#include <algorithm>
+
+#include "Renderer.h"
+#include "Shader.h"
+#include "UniformBuffer.h"
+#include "UniformRingBuffer.h"
+
+ObjectPicker::ObjectPicker()
+    : m_Width(0), m_Height(0), m_FBO(0), m_IDTexture(0), m_DepthBuffer(0),
+      m_Requested(false), m_RequestX(0), m_RequestY(0), m_Oldest(0), m_InFlight(0)
+{
+    m_Shader.reset(new Shader("res/shaders/ObjectID.shader"));
+
+    GLCall(glGenFramebuffers(1, &m_FBO));
+    for (Readback& readback : m_Readbacks)
+    {
+        GLCall(glGenBuffers(1, &readback.PBO));
+        GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO));
+        GLCall(glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(uint32_t), nullptr, GL_STREAM_READ));
+        readback.Fence = nullptr;
+    }
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+}
+
+ObjectPicker::~ObjectPicker()
+{
+    for (Readback& readback : m_Readbacks)
+    {
+        if (readback.Fence)
+        {
+            GLCall(glDeleteSync(readback.Fence));
+        }
+        GLCall(glDeleteBuffers(1, &readback.PBO));
+    }
+    DeleteTargets();
+    GLCall(glDeleteFramebuffers(1, &m_FBO));
+}
+
+void ObjectPicker::RequestPick(int x, int y)
+{
+    m_Requested = true;
+    m_RequestX = x;
+    m_RequestY = y;
+}
+
+void ObjectPicker::Submit(const VertexArray& va, const IndexBuffer& ib, unsigned int objectOffset, uint32_t id,
+                          unsigned int firstIndex, unsigned int indexCount)
+{
+    if (!m_Requested)
+        return;
+
+    if (indexCount == 0)
+        indexCount = ib.GetCount() - firstIndex;
+    m_Items.push_back({ &va, &ib, objectOffset, firstIndex, indexCount, id });
+}
+
+void ObjectPicker::Render(int width, int height, const UniformRingBuffer& objects)
+{
+    if (!m_Requested || !m_Shader->IsReady() || width <= 0 || height <= 0)
+    {
+        m_Items.clear();
+        return;
+    }
+    m_Requested = false;
+
+    //every slot still waiting on the GPU, drop this request rather than wait
+    if (m_InFlight == ReadbackCount)
+    {
+        std::cout << "[ObjectPicker] Too many picks in flight, request dropped" << std::endl;
+        m_Items.clear();
+        return;
+    }
+
+    if (width != m_Width || height != m_Height)
+        CreateTargets(width, height);
+
+    int x = std::min(std::max(m_RequestX, 0), width - 1);
+    int y = std::min(std::max(height - 1 - m_RequestY, 0), height - 1);
+
+    int readFBO, drawFBO, viewport[4];
+    GLCall(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFBO));
+    GLCall(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFBO));
+    GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+    GLCall(bool blend = glIsEnabled(GL_BLEND) == GL_TRUE);
+    GLCall(bool depthTest = glIsEnabled(GL_DEPTH_TEST) == GL_TRUE);
+
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_FBO));
+    GLCall(glViewport(0, 0, width, height));
+    GLCall(glDisable(GL_BLEND));
+    GLCall(glEnable(GL_DEPTH_TEST));
+    //only the pixel that is read needs shading, the scissor limits clears too
+    GLCall(glEnable(GL_SCISSOR_TEST));
+    GLCall(glScissor(x, y, 1, 1));
+
+    const GLuint empty[4] = { 0, 0, 0, 0 };
+    const GLfloat farDepth = 1.0f;
+    GLCall(glClearBufferuiv(GL_COLOR, 0, empty));
+    GLCall(glClearBufferfv(GL_DEPTH, 0, &farDepth));
+
+    m_Shader->Bind();
+    for (const DrawItem& item : m_Items)
+    {
+        objects.BindRange(UniformBinding::Object, item.ObjectOffset, sizeof(ObjectBlock));
+        m_Shader->SetUniform1i("u_ObjectID", (int)(item.ID + 1));
+        m_Shader->FlushUniforms();
+        item.VA->Bind();
+        item.IB->Bind();
+        GLCall(glDrawElements(GL_TRIANGLES, item.IndexCount, GL_UNSIGNED_INT, (const void*)(item.FirstIndex * sizeof(unsigned int))));
+    }
+    m_Items.clear();
+
+    //into a PBO the read only queues a copy, the fence tells Poll when it landed
+    Readback& readback = m_Readbacks[(m_Oldest + m_InFlight) % ReadbackCount];
+    GLCall(glReadBuffer(GL_COLOR_ATTACHMENT0));
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO));
+    GLCall(glReadPixels(x, y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr));
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+    GLCall(readback.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    m_InFlight++;
+
+    GLCall(glDisable(GL_SCISSOR_TEST));
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, readFBO));
+    GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFBO));
+    GLCall(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
+    if (blend)
+    {
+        GLCall(glEnable(GL_BLEND));
+    }
+    if (!depthTest)
+    {
+        GLCall(glDisable(GL_DEPTH_TEST));
+    }
+}
+
+bool ObjectPicker::Poll(uint32_t& id)
+{
+    if (m_InFlight == 0)
+        return false;
+
+    //timeout 0 only asks, the flush makes sure the fence gets to the GPU at all
+    Readback& readback = m_Readbacks[m_Oldest];
+    GLCall(GLenum status = glClientWaitSync(readback.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return false;
+
+    GLCall(glDeleteSync(readback.Fence));
+    readback.Fence = nullptr;
+    m_Oldest = (m_Oldest + 1) % ReadbackCount;
+    m_InFlight--;
+
+    uint32_t value = 0;
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.PBO));
+    GLCall(const uint32_t* data = (const uint32_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(uint32_t), GL_MAP_READ_BIT));
+    if (data)
+    {
+        value = *data;
+        GLCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+    }
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+    id = value == 0 ? NoObject : value - 1;
+    return true;
+}
+
+void ObjectPicker::CreateTargets(int width, int height)
+{
+    DeleteTargets();
+    m_Width	 = width;
+    m_Height = height;
+
+    GLCall(glGenTextures(1, &m_IDTexture));
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_IDTexture));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
+    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr));
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+    GLCall(glGenRenderbuffers(1, &m_DepthBuffer));
+    GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_DepthBuffer));
+    GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height));
+    GLCall(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+    int previous;
+    GLCall(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_FBO));
+    GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_IDTexture, 0));
+    GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_DepthBuffer));
+    GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "[ObjectPicker] Incomplete id framebuffer: " << status << std::endl;
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, previous));
+}
+
+void ObjectPicker::DeleteTargets()
+{
+    if (m_IDTexture)
+    {
+        GLCall(glDeleteTextures(1, &m_IDTexture));
+    }
+    if (m_DepthBuffer)
+    {
+        GLCall(glDeleteRenderbuffers(1, &m_DepthBuffer));
+    }
+    m_IDTexture = m_DepthBuffer = 0;
+    m_Width = m_Height = 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+class Shader;
+class VertexArray;
+class IndexBuffer;
+class UniformRingBuffer;
+
+static const uint32_t NoObject = 0xFFFFFFFF;
+
+// Exact mouse picking: an id pass draws the submitted objects into an integer render target and the pixel under
+// the cursor is read back. glReadPixels goes into a PBO guarded by a fence, and Poll only maps it once the fence
+// has signaled, so a pick never stalls the pipeline; the answer arrives a frame or two after the request.
+// The pass only runs on frames with a request, scissored to the one pixel that is read.
+//
+// Per frame:
+//   if (click) picker.RequestPick(x, y);  submit while IsPickPending();  picker.Render(width, height, objects);
+//   if (picker.Poll(id)) ...
+class ObjectPicker
+{
+private:
+	struct DrawItem
+	{
+		const VertexArray* VA;
+		const IndexBuffer* IB;
+		unsigned int	   ObjectOffset;
+		unsigned int	   FirstIndex;
+		unsigned int	   IndexCount;
+		uint32_t		   ID;
+	};
+
+	struct Readback
+	{
+		unsigned int PBO;
+		GLsync		 Fence; // nullptr when the slot is free
+	};
+
+	static const int ReadbackCount = 3;
+
+	int			 m_Width, m_Height;
+	unsigned int m_FBO;
+	unsigned int m_IDTexture;	// R32UI, id + 1 per pixel
+	unsigned int m_DepthBuffer;
+	std::unique_ptr<Shader> m_Shader;
+
+	std::vector<DrawItem> m_Items;
+	bool				  m_Requested;
+	int					  m_RequestX, m_RequestY;
+
+	// in flight readbacks, oldest at m_Oldest
+	Readback m_Readbacks[ReadbackCount];
+	int		 m_Oldest, m_InFlight;
+
+public:
+	ObjectPicker();
+	~ObjectPicker();
+
+	ObjectPicker(const ObjectPicker&) = delete;
+	ObjectPicker& operator=(const ObjectPicker&) = delete;
+
+	// Framebuffer pixel with the origin at the top left, like mouse positions. Read during the next Render.
+	void RequestPick(int x, int y);
+	inline bool IsPickPending() const { return m_Requested; }
+
+	// Queues an object for the id pass, same arguments as Renderer::Submit plus the id Poll reports for it
+	void Submit(const VertexArray& va, const IndexBuffer& ib, unsigned int objectOffset, uint32_t id,
+				unsigned int firstIndex = 0, unsigned int indexCount = 0);
+
+	// Draws the queued objects if a pick is pending and starts reading the pixel back. The objects' ranges of the
+	// ring buffer must still be flushed and in this frame's segment.
+	void Render(int width, int height, const UniformRingBuffer& objects);
+
+	// True when a pick finished since the last call, id is NoObject if the pixel was empty. Never waits.
+	bool Poll(uint32_t& id);
+
+private:
+	void CreateTargets(int width, int height);
+	void DeleteTargets();
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+class VertexArray;
+class IndexBuffer;
+class MaterialInstance;
+class MeshLOD;
+
+// Components of a drawable entity, see EntityWorld and RenderExtraction
+
+struct TransformComponent
+{
+	glm::vec3 Position;
+	glm::quat Rotation;
+	glm::vec3 Scale;
+};
+
+struct MeshComponent
+{
+	const VertexArray* VA;
+	const IndexBuffer* IB;	  // the LOD's index buffer if it has one
+	const MeshLOD*	   LOD;	  // nullptr draws all of IB
+	unsigned int	   Level; // selected by the last extraction, kept for hysteresis
+};
+
+struct MaterialComponent
+{
+	MaterialInstance* Instance;
+	glm::vec4		  Color; // ObjectBlock::Color
+};
+
+// Sphere around the mesh in its own space
+struct BoundsComponent
+{
+	glm::vec3 Center;
+	float	  Radius;
+};
+
+struct VisibilityComponent
+{
+	bool Hidden;  // set by the game, skipped without testing
+	bool Visible; // result of the last extraction
+};
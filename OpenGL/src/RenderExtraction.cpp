@@ -0,0 +1,166 @@
+#include "RenderExtraction.h"
+
+#include <algorithm>
+
+#include "TransformKernels.h"
+#include "UniformRingBuffer.h"
+#include "UniformBuffer.h"
+#include "HiZBuffer.h"
+#include "Camera.h"
+#include "MeshLOD.h"
+#include "ObjectPicker.h"
+
+RenderExtraction::RenderExtraction()
+    : m_Frame(1), m_ChunkCount(0), m_FrustumCulled(0), m_Entities(0), m_Stats{ 0, 0, 0, 0 }, m_LODThreshold(1.0f), m_LODHysteresis(0.25f), m_Picker(nullptr)
+{
+}
+
+void RenderExtraction::SetLODThreshold(float pixels, float hysteresis)
+{
+    m_LODThreshold = pixels;
+    m_LODHysteresis = hysteresis;
+}
+
+void RenderExtraction::Extract(EntityWorld& world, const Camera& camera, UniformRingBuffer& objects, Renderer& renderer, HiZBuffer* hiZ, unsigned int threads)
+{
+    const Frustum& frustum = camera.GetFrustum();
+    const glm::mat4& viewProjection = camera.GetUnjitteredViewProjection();
+    //pixels per unit at clip w = 1, dividing by an object's w gives its own
+    float pixelsPerUnit = camera.GetUnjitteredProjection()[1][1] * 0.5f * camera.GetViewportSize().y;
+
+    m_Stats = { 0, 0, 0, 0 };
+    m_ChunkCount = 0;
+    m_FrustumCulled = 0;
+    m_Entities = 0;
+    //one result list per chunk, so the chunks need no lock; sized up front since threads index into it
+    m_Chunks.resize(std::max<size_t>(m_Chunks.size(), world.GetChunkCount()));
+    m_Moved.resize(m_Chunks.size());
+    m_Previous.resize(std::max<size_t>(m_Previous.size(), world.GetIndexLimit()), { 0, 0, glm::vec3(0.0f), 0.0f });
+    m_Frame++;
+
+    world.ForEachChunk<TransformComponent, MeshComponent, MaterialComponent, BoundsComponent, VisibilityComponent>(
+        [this, &frustum, &viewProjection, pixelsPerUnit](uint32_t count, const Entity* entities, TransformComponent* transforms, MeshComponent* meshes, MaterialComponent* materials,
+               BoundsComponent* bounds, VisibilityComponent* visibility)
+    {
+        uint32_t slot = m_ChunkCount++;
+        std::vector<Item>& items = m_Chunks[slot];
+        std::vector<BoundingBox>& moved = m_Moved[slot];
+        items.clear();
+        moved.clear();
+
+        //the kernels take one array per input, per thread scratch so chunks allocate nothing
+        static thread_local std::vector<glm::vec3> positions, scales;
+        static thread_local std::vector<glm::quat> rotations;
+        static thread_local std::vector<glm::mat4> models;
+        positions.resize(count);
+        scales.resize(count);
+        rotations.resize(count);
+        models.resize(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            positions[i] = transforms[i].Position;
+            rotations[i] = transforms[i].Rotation;
+            scales[i]	 = transforms[i].Scale;
+        }
+        TransformKernels::ComposeTRS(positions.data(), rotations.data(), scales.data(), count, models.data());
+
+        uint32_t culled = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            visibility[i].Visible = false;
+            if (visibility[i].Hidden)
+                continue;
+
+            const glm::mat4& model = models[i];
+            glm::vec3 center = glm::vec3(model * glm::vec4(bounds[i].Center, 1.0f));
+            float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+            float radius = bounds[i].Radius * scale;
+
+            //indices are unique, so threads never share an entry. A reused index means the old entity is gone
+            Previous& previous = m_Previous[entities[i].Index];
+            if (previous.Frame == m_Frame - 1 && (previous.Generation != entities[i].Generation || previous.Center != center || previous.Radius != radius))
+                moved.push_back({ previous.Center - glm::vec3(previous.Radius), previous.Center + glm::vec3(previous.Radius) });
+            previous = { entities[i].Generation, m_Frame, center, radius };
+
+            if (!FrustumCulling::IsVisible(frustum, center, radius))
+            {
+                culled++;
+                continue;
+            }
+
+            unsigned int firstIndex = 0, indexCount = 0;
+            if (meshes[i].LOD)
+            {
+                float w = viewProjection[0][3] * center.x + viewProjection[1][3] * center.y + viewProjection[2][3] * center.z + viewProjection[3][3];
+                float scaled = scale * pixelsPerUnit / std::max(w, 1e-4f);
+                meshes[i].Level = meshes[i].LOD->SelectLevel(meshes[i].Level, scaled, m_LODThreshold, m_LODHysteresis);
+                const LODLevel& level = meshes[i].LOD->GetLevels()[meshes[i].Level];
+                firstIndex = level.FirstIndex;
+                indexCount = level.IndexCount;
+            }
+
+            visibility[i].Visible = true;
+            items.push_back({ entities[i], model, materials[i].Color, center, radius, meshes[i], firstIndex, indexCount, materials[i].Instance, &visibility[i] });
+        }
+        m_FrustumCulled += culled;
+        m_Entities += count;
+    }, threads);
+
+    m_Stats.Entities = m_Entities;
+    m_Stats.FrustumCulled = m_FrustumCulled;
+
+    //Hi-Z testing and submitting touch shared state, so the rest is serial
+    uint32_t chunkCount = m_ChunkCount;
+    if (hiZ)
+    {
+        //last frame's depth still shows these where they were
+        for (uint32_t c = 0; c < chunkCount; c++)
+            for (const BoundingBox& bounds : m_Moved[c])
+                hiZ->Invalidate(bounds);
+        //extracted last frame but not this one: destroyed, hidden or lost a component
+        for (const Previous& previous : m_Previous)
+            if (previous.Frame == m_Frame - 1)
+                hiZ->Invalidate({ previous.Center - glm::vec3(previous.Radius), previous.Center + glm::vec3(previous.Radius) });
+
+        for (uint32_t c = 0; c < chunkCount; c++)
+        {
+            std::vector<Item>& items = m_Chunks[c];
+            auto end = std::remove_if(items.begin(), items.end(), [hiZ](const Item& item)
+            {
+                if (hiZ->IsVisible({ item.Center - glm::vec3(item.Radius), item.Center + glm::vec3(item.Radius) }))
+                    return false;
+                item.Visibility->Visible = false;
+                return true;
+            });
+            m_Stats.OcclusionCulled += (uint32_t)(items.end() - end);
+            items.erase(end, items.end());
+        }
+    }
+
+    uint32_t total = 0;
+    for (uint32_t c = 0; c < chunkCount; c++)
+        total += (uint32_t)m_Chunks[c].size();
+    if (total == 0)
+        return;
+
+    //every ObjectBlock of the frame in one allocation, written in place
+    unsigned char* data;
+    unsigned int offset = objects.Allocate(sizeof(ObjectBlock), total, data);
+    unsigned int stride = objects.GetStride(sizeof(ObjectBlock));
+    for (uint32_t c = 0; c < chunkCount; c++)
+    {
+        for (const Item& item : m_Chunks[c])
+        {
+            ObjectBlock* block = (ObjectBlock*)data;
+            block->Model = item.Model;
+            block->Color = item.Color;
+            renderer.Submit(*item.Mesh.VA, *item.Mesh.IB, *item.Material, offset, item.FirstIndex, item.IndexCount);
+            if (m_Picker)
+                m_Picker->Submit(*item.Mesh.VA, *item.Mesh.IB, offset, item.Owner.Index, item.FirstIndex, item.IndexCount);
+
+            data   += stride;
+            offset += stride;
+        }
+    }
+    m_Stats.Submitted = total;
+}
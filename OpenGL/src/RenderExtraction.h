@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include "glm/glm.hpp"
+
+#include "EntityWorld.h"
+#include "RenderComponents.h"
+#include "FrustumCulling.h"
+#include "BVH.h"
+
+class UniformRingBuffer;
+class HiZBuffer;
+class Camera;
+class ObjectPicker;
+
+// Counted during the last Extract
+struct ExtractionStats
+{
+	uint32_t Entities;
+	uint32_t FrustumCulled;
+	uint32_t OcclusionCulled;
+	uint32_t Submitted;
+};
+
+// Turns every entity with a transform, mesh, material, bounds and visibility into a draw. Chunks are processed in
+// parallel: the world matrices of a whole chunk are built with TransformKernels and the bounds are frustum culled.
+// The survivors are then tested against the Hi-Z buffer if one is given, after it was told the old bounds of every
+// entity that moved, vanished or got hidden since last frame. Their ObjectBlocks are written in place
+// into the ring buffer and they are submitted to the renderer, which sorts them. VisibilityComponent::Visible
+// receives the outcome. Meshes with a MeshLOD get their level picked in the same parallel pass, from the error of
+// each level projected to pixels. With a picker set, submitted entities also go to its id pass under their index.
+class RenderExtraction
+{
+private:
+	struct Item
+	{
+		Entity				 Owner;
+		glm::mat4			 Model;
+		glm::vec4			 Color;
+		glm::vec3			 Center; // world bounds
+		float				 Radius;
+		MeshComponent		 Mesh;
+		unsigned int		 FirstIndex;
+		unsigned int		 IndexCount;
+		MaterialInstance*	 Material;
+		VisibilityComponent* Visibility;
+	};
+
+	// world bounds of every entity as of the last frame it was extracted in
+	struct Previous
+	{
+		uint32_t  Generation;
+		uint32_t  Frame;
+		glm::vec3 Center;
+		float	  Radius;
+	};
+
+	std::vector<std::vector<Item>>		  m_Chunks;	  // per processed chunk, reused across frames
+	std::vector<std::vector<BoundingBox>> m_Moved;	  // per processed chunk, last frame's bounds of what moved
+	std::vector<Previous>				  m_Previous; // by entity index
+	uint32_t							  m_Frame;
+	std::atomic<uint32_t>		   m_ChunkCount;
+	std::atomic<uint32_t>		   m_FrustumCulled;
+	std::atomic<uint32_t>		   m_Entities;
+	ExtractionStats				   m_Stats;
+	float						   m_LODThreshold;
+	float						   m_LODHysteresis;
+	ObjectPicker*				   m_Picker;
+
+public:
+	RenderExtraction();
+
+	// Culls with the camera's unjittered frustum, its viewport size turns LOD errors into pixels.
+	// threads = 0 uses every hardware thread
+	void Extract(EntityWorld& world, const Camera& camera, UniformRingBuffer& objects, Renderer& renderer, HiZBuffer* hiZ = nullptr, unsigned int threads = 0);
+
+	// Largest error in pixels a LOD may have, see MeshLOD::SelectLevel
+	void SetLODThreshold(float pixels, float hysteresis = 0.25f);
+	void SetPicker(ObjectPicker* picker) { m_Picker = picker; }
+
+	inline const ExtractionStats& GetStats() const { return m_Stats; }
+};
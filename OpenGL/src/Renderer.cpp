@@ -1,6 +1,10 @@
 #include "Renderer.h"
 
 #include <iostream>
+#include <algorithm>
+
+#include "MaterialInstance.h"
+#include "UniformRingBuffer.h"
 
 void GLClearError()
 {
@@ -25,15 +29,105 @@ void Renderer::SetClearColor(float r, float g, float b, float a)
 
 void Renderer::Clear() const
 {
-    GLCall(glClear(GL_COLOR_BUFFER_BIT));
+    //depth too, HiZBuffer reads it back every frame
+    GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 }
 
 void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
 {
-    shader.Bind();
+    const Shader* program = &shader;
+    if (!program->IsReady())
+    {
+        program = m_FallbackShader;
+        if (!program || !program->IsReady())
+            return;
+    }
+
+#ifdef _DEBUG
+    //drawing a VAO laid out for other locations reads garbage, better to see nothing and a warning
+    if (!program->CanDraw(va))
+        return;
+#endif
+
+    program->Bind();
+    program->FlushUniforms();
     va.Bind();
     ib.Bind();
 
     //draw currently bound buffer, 6 indices
     GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
 }
+
+void Renderer::Submit(const VertexArray& va, const IndexBuffer& ib, MaterialInstance& material, unsigned int objectOffset,
+                      unsigned int firstIndex, unsigned int indexCount)
+{
+    Material& parent = material.GetMaterial();
+    uint64_t key = ((uint64_t)(parent.GetShader().GetRendererID() & 0xFFFF) << 48)
+                 | ((uint64_t)(parent.GetID() & 0xFFFFFF) << 24)
+                 |  (uint64_t)(material.GetID() & 0xFFFFFF);
+
+    if (indexCount == 0)
+        indexCount = ib.GetCount() - firstIndex;
+
+    m_Commands.push_back({ key, &va, &ib, &material, objectOffset, firstIndex, indexCount });
+}
+
+void Renderer::Flush()
+{
+    m_Stats = {};
+
+    //stable so draws within one instance keep their submission order
+    std::stable_sort(m_Commands.begin(), m_Commands.end(), [](const DrawCommand& a, const DrawCommand& b) { return a.Key < b.Key; });
+
+    const Shader*           shader   = nullptr;
+    const Material*         material = nullptr;
+    const MaterialInstance* instance = nullptr;
+    for (const DrawCommand& command : m_Commands)
+    {
+        Material& nextMaterial = command.Material->GetMaterial();
+        Shader& nextShader = nextMaterial.GetShader();
+        if (!nextShader.IsReady())
+            continue;
+
+#ifdef _DEBUG
+        if (!nextShader.CanDraw(*command.VA))
+            continue;
+#endif
+
+        if (&nextShader != shader)
+        {
+            nextShader.Bind();
+            shader = &nextShader;
+            material = nullptr;
+            m_Stats.ShaderBinds++;
+        }
+
+        if (&nextMaterial != material)
+        {
+            nextMaterial.Upload();
+            nextMaterial.Bind();
+            material = &nextMaterial;
+            instance = nullptr;
+            m_Stats.MaterialBinds++;
+        }
+
+        if (command.Material != instance)
+        {
+            command.Material->Bind();
+            instance = command.Material;
+            m_Stats.InstanceBinds++;
+        }
+
+        if (m_ObjectBuffer)
+            m_ObjectBuffer->BindRange(UniformBinding::Object, command.ObjectOffset, sizeof(ObjectBlock));
+
+        nextShader.FlushUniforms();
+        command.VA->Bind();
+        command.IB->Bind();
+        GLCall(glDrawElements(GL_TRIANGLES, command.IndexCount, GL_UNSIGNED_INT, (const void*)(command.FirstIndex * sizeof(unsigned int))));
+        m_Stats.DrawCalls++;
+        m_Stats.Triangles += command.IndexCount / 3;
+    }
+
+    m_Commands.clear();
+}
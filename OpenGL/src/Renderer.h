@@ -1,5 +1,8 @@
 #pragma once
 
+#include <vector>
+#include <cstdint>
+
 #include <GL/glew.h>
 #include "VertexArray.h"
 #include "IndexBuffer.h"
@@ -14,11 +17,55 @@
 void GLClearError();
 bool GLLogCall(const char* function, const char* file, int line);
 
+class MaterialInstance;
+class UniformRingBuffer;
+
+// A draw queued with Renderer::Submit, the key orders by program, then material, then instance
+struct DrawCommand
+{
+    uint64_t            Key;
+    const VertexArray*  VA;
+    const IndexBuffer*  IB;
+    MaterialInstance*   Material;
+    unsigned int        ObjectOffset;
+    unsigned int        FirstIndex;
+    unsigned int        IndexCount;
+};
+
+// Counted during the last Renderer::Flush
+struct RendererStats
+{
+    unsigned int DrawCalls;
+    unsigned int ShaderBinds;
+    unsigned int MaterialBinds;
+    unsigned int InstanceBinds;
+    unsigned int Triangles;
+};
+
 class Renderer 
 {
+private:
+    const Shader* m_FallbackShader = nullptr;
+    const UniformRingBuffer* m_ObjectBuffer = nullptr;
+    std::vector<DrawCommand> m_Commands;
+    RendererStats m_Stats = {};
+
 public:
     void SetClearColor(float r, float g, float b, float a);
+    // drawn with instead of shaders that are still compiling, without one those draws are skipped
+    void SetFallbackShader(const Shader* shader) { m_FallbackShader = shader; }
 
     void Clear() const;
     void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+
+    // Object blocks of submitted draws are ranges of this buffer
+    void SetObjectBuffer(const UniformRingBuffer* buffer) { m_ObjectBuffer = buffer; }
+    // Queues a draw, objectOffset is what UniformRingBuffer::Allocate returned for its ObjectBlock
+    // indexCount 0 draws the whole index buffer, otherwise a range of it (a level of a MeshLOD)
+    void Submit(const VertexArray& va, const IndexBuffer& ib, MaterialInstance& material, unsigned int objectOffset,
+                unsigned int firstIndex = 0, unsigned int indexCount = 0);
+    // Draws everything submitted, sorted so programs, materials and instances are bound once per bucket
+    void Flush();
+
+    inline const RendererStats& GetStats() const { return m_Stats; }
 };
\ No newline at end of file
@@ -0,0 +1,466 @@
+#include "SceneGraph.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "Renderer.h"
+#include "CpuFeatures.h"
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+// Below this many nodes to recompute the threads cost more than they save
+static const uint32_t ParallelThreshold = 16 * 1024;
+
+// Index of the lowest set bit, word must not be 0
+static inline uint32_t LowestBit(uint64_t word)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, (unsigned long)word))
+        return index;
+    _BitScanForward(&index, (unsigned long)(word >> 32));
+    return index + 32;
+#else
+    return (uint32_t)__builtin_ctzll(word);
+#endif
+}
+
+// Ranges are scattered over the arrays, so Update asks for the data of the ones a few ahead while computing this one
+static const size_t PrefetchDistance = 8;
+// of at most this many nodes each, the hardware prefetcher picks up the rest of long ranges
+static const uint32_t PrefetchNodes = 16;
+// and the subtree sizes of the dirty nodes this many bitset words ahead while collecting the ranges
+static const size_t PrefetchWords = 8;
+
+static inline void Prefetch(const void* address)
+{
+#if CPU_X86
+    _mm_prefetch((const char*)address, _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+// world = parent * translate(p) * mat4_cast(q) * scale(s), parent is nullptr for roots. The local matrix stays
+// in registers, only its three rotation columns and the translation weight the parent's columns.
+static inline void ComposeWorld(const glm::mat4* parent, const glm::vec3& p, const glm::quat& q, const glm::vec3& s, glm::mat4& world)
+{
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    float m[3][3] = {
+        { (1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy + wz) * s.x, 2.0f * (xz - wy) * s.x },
+        { 2.0f * (xy - wz) * s.y, (1.0f - 2.0f * (xx + zz)) * s.y, 2.0f * (yz + wx) * s.y },
+        { 2.0f * (xz + wy) * s.z, 2.0f * (yz - wx) * s.z, (1.0f - 2.0f * (xx + yy)) * s.z }
+    };
+
+    if (!parent)
+    {
+        world[0] = glm::vec4(m[0][0], m[0][1], m[0][2], 0.0f);
+        world[1] = glm::vec4(m[1][0], m[1][1], m[1][2], 0.0f);
+        world[2] = glm::vec4(m[2][0], m[2][1], m[2][2], 0.0f);
+        world[3] = glm::vec4(p, 1.0f);
+        return;
+    }
+
+#if CPU_X86
+    const glm::mat4& a = *parent;
+    __m128 a0 = _mm_loadu_ps(&a[0][0]), a1 = _mm_loadu_ps(&a[1][0]), a2 = _mm_loadu_ps(&a[2][0]), a3 = _mm_loadu_ps(&a[3][0]);
+    float* o = &world[0][0];
+    for (int j = 0; j < 3; j++)
+    {
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(m[j][0]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(m[j][1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(m[j][2])));
+        _mm_storeu_ps(o + j * 4, r);
+    }
+    __m128 t = _mm_add_ps(a3, _mm_mul_ps(a0, _mm_set1_ps(p.x)));
+    t = _mm_add_ps(t, _mm_mul_ps(a1, _mm_set1_ps(p.y)));
+    t = _mm_add_ps(t, _mm_mul_ps(a2, _mm_set1_ps(p.z)));
+    _mm_storeu_ps(o + 12, t);
+#else
+    const glm::mat4& a = *parent;
+    world[0] = a[0] * m[0][0] + a[1] * m[0][1] + a[2] * m[0][2];
+    world[1] = a[0] * m[1][0] + a[1] * m[1][1] + a[2] * m[1][2];
+    world[2] = a[0] * m[2][0] + a[1] * m[2][1] + a[2] * m[2][2];
+    world[3] = a[0] * p.x + a[1] * p.y + a[2] * p.z + a[3];
+#endif
+}
+
+// v[i] = v[order[i]]
+template<typename T>
+static void Permute(std::vector<T>& v, const std::vector<uint32_t>& order)
+{
+    std::vector<T> permuted(v.size());
+    for (size_t i = 0; i < order.size(); i++)
+        permuted[i] = v[order[i]];
+    v.swap(permuted);
+}
+
+SceneGraph::SceneGraph()
+    : m_DirtyCount(0), m_OrderDirty(false)
+{
+}
+
+NodeID SceneGraph::Create(NodeID parent)
+{
+    NodeID id;
+    if (!m_FreeIDs.empty())
+    {
+        id = m_FreeIDs.back();
+        m_FreeIDs.pop_back();
+    }
+    else
+    {
+        id = (NodeID)m_Indices.size();
+        m_Indices.push_back(InvalidNode);
+    }
+
+    uint32_t index = (uint32_t)m_IDs.size();
+    m_Positions.push_back(glm::vec3(0.0f));
+    m_Rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    m_Scales.push_back(glm::vec3(1.0f));
+    m_World.push_back(glm::mat4(1.0f));
+    m_Parents.push_back(InvalidNode);
+    m_SubtreeSizes.push_back(1);
+    m_IDs.push_back(id);
+    if (index % 64 == 0)
+        m_DirtyBits.push_back(0);
+    m_Indices[id] = index;
+
+    if (parent != InvalidNode)
+    {
+        uint32_t p = m_Indices[parent];
+        m_Parents[index] = p;
+
+        //appending right behind the parent's subtree keeps depth first order, anything else is sorted by the next Update
+        if (!m_OrderDirty && p + m_SubtreeSizes[p] == index)
+        {
+            for (uint32_t a = p; a != InvalidNode; a = m_Parents[a])
+                m_SubtreeSizes[a]++;
+        }
+        else
+            m_OrderDirty = true;
+    }
+
+    MarkDirty(index);
+    return id;
+}
+
+void SceneGraph::Destroy(NodeID node)
+{
+    if (m_OrderDirty)
+        Reorder();
+
+    uint32_t begin = m_Indices[node];
+    uint32_t count = m_SubtreeSizes[begin];
+    uint32_t end   = begin + count;
+
+    for (uint32_t a = m_Parents[begin]; a != InvalidNode; a = m_Parents[a])
+        m_SubtreeSizes[a] -= count;
+
+    for (uint32_t i = begin; i < end; i++)
+    {
+        m_Indices[m_IDs[i]] = InvalidNode;
+        m_FreeIDs.push_back(m_IDs[i]);
+    }
+
+    std::vector<uint32_t> dirty;
+    TakeDirty(dirty);
+
+    m_Positions.erase(m_Positions.begin() + begin, m_Positions.begin() + end);
+    m_Rotations.erase(m_Rotations.begin() + begin, m_Rotations.begin() + end);
+    m_Scales.erase(m_Scales.begin() + begin, m_Scales.begin() + end);
+    m_World.erase(m_World.begin() + begin, m_World.begin() + end);
+    m_Parents.erase(m_Parents.begin() + begin, m_Parents.begin() + end);
+    m_SubtreeSizes.erase(m_SubtreeSizes.begin() + begin, m_SubtreeSizes.begin() + end);
+    m_IDs.erase(m_IDs.begin() + begin, m_IDs.begin() + end);
+
+    //everything behind the removed range moves down, nodes in front of it cant have a parent behind it
+    for (uint32_t i = begin; i < m_IDs.size(); i++)
+    {
+        m_Indices[m_IDs[i]] = i;
+        if (m_Parents[i] != InvalidNode && m_Parents[i] >= end)
+            m_Parents[i] -= count;
+    }
+
+    m_DirtyBits.resize((m_IDs.size() + 63) / 64);
+    for (uint32_t index : dirty)
+    {
+        if (index < begin)
+            MarkDirty(index);
+        else if (index >= end)
+            MarkDirty(index - count);
+    }
+}
+
+void SceneGraph::SetParent(NodeID node, NodeID parent)
+{
+    uint32_t index = m_Indices[node];
+    uint32_t p = parent == InvalidNode ? InvalidNode : m_Indices[parent];
+
+    //a node cant become a child of its own subtree
+    for (uint32_t a = p; a != InvalidNode; a = m_Parents[a])
+        ASSERT(a != index);
+
+    m_Parents[index] = p;
+    m_OrderDirty = true;
+    MarkDirty(index);
+}
+
+NodeID SceneGraph::GetParent(NodeID node) const
+{
+    uint32_t p = m_Parents[m_Indices[node]];
+    return p == InvalidNode ? InvalidNode : m_IDs[p];
+}
+
+void SceneGraph::SetPosition(NodeID node, const glm::vec3& position)
+{
+    uint32_t index = m_Indices[node];
+    m_Positions[index] = position;
+    MarkDirty(index);
+}
+
+void SceneGraph::SetRotation(NodeID node, const glm::quat& rotation)
+{
+    uint32_t index = m_Indices[node];
+    m_Rotations[index] = rotation;
+    MarkDirty(index);
+}
+
+void SceneGraph::SetScale(NodeID node, const glm::vec3& scale)
+{
+    uint32_t index = m_Indices[node];
+    m_Scales[index] = scale;
+    MarkDirty(index);
+}
+
+void SceneGraph::Update(unsigned int threads)
+{
+    if (m_OrderDirty)
+        Reorder();
+
+    if (m_DirtyCount == 0)
+        return;
+
+    //the set bits come out in index order, a dirty node inside an earlier dirty subtree is recomputed with it
+    std::vector<Range>& ranges = m_Ranges;
+    ranges.clear();
+    uint32_t total = 0;
+    uint32_t covered = 0;
+    for (size_t w = 0; w < m_DirtyBits.size(); w++)
+    {
+        if (w + PrefetchWords < m_DirtyBits.size())
+        {
+            for (uint64_t ahead = m_DirtyBits[w + PrefetchWords]; ahead; ahead &= ahead - 1)
+                Prefetch(&m_SubtreeSizes[(w + PrefetchWords) * 64 + LowestBit(ahead)]);
+        }
+
+        uint64_t bits = m_DirtyBits[w];
+        if (!bits)
+            continue;
+        m_DirtyBits[w] = 0;
+
+        for (; bits; bits &= bits - 1)
+        {
+            uint32_t index = (uint32_t)(w * 64) + LowestBit(bits);
+            if (index < covered)
+                continue;
+
+            covered = index + m_SubtreeSizes[index];
+            ranges.push_back({ index, covered });
+            total += m_SubtreeSizes[index];
+        }
+    }
+    m_DirtyCount = 0;
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    if (threads == 1 || total < ParallelThreshold)
+    {
+        UpdateRanges(ranges.data(), ranges.size());
+        return;
+    }
+
+    //split subtrees too big for one thread into their root, done right here, and the subtrees of its children
+    uint32_t chunk = std::max(total / (threads * 4), 1u);
+    std::vector<Range> work;
+    while (!ranges.empty())
+    {
+        Range range = ranges.back();
+        ranges.pop_back();
+
+        if (range.End - range.Begin <= chunk)
+        {
+            work.push_back(range);
+            continue;
+        }
+
+        UpdateRange(range.Begin, range.Begin + 1);
+        for (uint32_t child = range.Begin + 1; child < range.End; child += m_SubtreeSizes[child])
+            ranges.push_back({ child, child + m_SubtreeSizes[child] });
+    }
+
+    //ranges are disjoint subtrees whose parents are final, so any thread can take any of them
+    uint32_t perThread = total / threads + 1;
+    std::vector<std::future<void>> jobs;
+    size_t first = 0;
+    uint32_t assigned = 0;
+    for (size_t i = 0; i < work.size(); i++)
+    {
+        assigned += work[i].End - work[i].Begin;
+        if (assigned < perThread && i + 1 < work.size())
+            continue;
+
+        jobs.push_back(std::async(std::launch::async, [this, &work, first, i]()
+        {
+            UpdateRanges(&work[first], i + 1 - first);
+        }));
+        first = i + 1;
+        assigned = 0;
+    }
+
+    for (auto& job : jobs)
+        job.wait();
+}
+
+void SceneGraph::MarkDirty(uint32_t index)
+{
+    uint64_t bit = 1ull << (index % 64);
+    if (m_DirtyBits[index / 64] & bit)
+        return;
+
+    m_DirtyBits[index / 64] |= bit;
+    m_DirtyCount++;
+}
+
+// Appends the dirty nodes in index order and clears them
+void SceneGraph::TakeDirty(std::vector<uint32_t>& indices)
+{
+    for (size_t w = 0; w < m_DirtyBits.size(); w++)
+    {
+        for (uint64_t bits = m_DirtyBits[w]; bits; bits &= bits - 1)
+            indices.push_back((uint32_t)(w * 64) + LowestBit(bits));
+        m_DirtyBits[w] = 0;
+    }
+    m_DirtyCount = 0;
+}
+
+// Sorts the nodes depth first, siblings keep their relative order
+void SceneGraph::Reorder()
+{
+    uint32_t count = (uint32_t)m_IDs.size();
+
+    //children of every node as one flat array, offsets[i]..offsets[i + 1]
+    std::vector<uint32_t> offsets(count + 1, 0);
+    for (uint32_t i = 0; i < count; i++)
+        if (m_Parents[i] != InvalidNode)
+            offsets[m_Parents[i] + 1]++;
+    for (uint32_t i = 0; i < count; i++)
+        offsets[i + 1] += offsets[i];
+
+    std::vector<uint32_t> children(offsets[count]);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t i = 0; i < count; i++)
+        if (m_Parents[i] != InvalidNode)
+            children[fill[m_Parents[i]]++] = i;
+
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    std::vector<uint32_t> stack;
+    for (uint32_t root = 0; root < count; root++)
+    {
+        if (m_Parents[root] != InvalidNode)
+            continue;
+
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            uint32_t i = stack.back();
+            stack.pop_back();
+            order.push_back(i);
+            for (uint32_t c = offsets[i + 1]; c > offsets[i]; c--)
+                stack.push_back(children[c - 1]);
+        }
+    }
+    ASSERT(order.size() == count);
+
+    std::vector<uint32_t> newIndex(count);
+    for (uint32_t i = 0; i < count; i++)
+        newIndex[order[i]] = i;
+
+    std::vector<uint32_t> dirty;
+    TakeDirty(dirty);
+    for (uint32_t index : dirty)
+        MarkDirty(newIndex[index]);
+
+    Permute(m_Positions, order);
+    Permute(m_Rotations, order);
+    Permute(m_Scales, order);
+    Permute(m_World, order);
+    Permute(m_Parents, order);
+    Permute(m_IDs, order);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (m_Parents[i] != InvalidNode)
+            m_Parents[i] = newIndex[m_Parents[i]];
+        m_Indices[m_IDs[i]] = i;
+    }
+
+    //children come after their parent, so walking backwards finishes every subtree before its root
+    m_SubtreeSizes.assign(count, 1);
+    for (uint32_t i = count; i-- > 0;)
+        if (m_Parents[i] != InvalidNode)
+            m_SubtreeSizes[m_Parents[i]] += m_SubtreeSizes[i];
+
+    m_OrderDirty = false;
+}
+
+void SceneGraph::UpdateRanges(const Range* ranges, size_t count)
+{
+    //the parent's index is only known once it arrived, so its world matrix is asked for one step later
+    for (size_t i = 0; i < std::min(count, PrefetchDistance * 2); i++)
+        Prefetch(&m_Parents[ranges[i].Begin]);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i + PrefetchDistance * 2 < count)
+            Prefetch(&m_Parents[ranges[i + PrefetchDistance * 2].Begin]);
+        if (i + PrefetchDistance < count)
+        {
+            //a world matrix is a cache line, the locals are a bit less, a line every four covers them
+            const Range& ahead = ranges[i + PrefetchDistance];
+            uint32_t end = std::min(ahead.End, ahead.Begin + PrefetchNodes);
+            for (uint32_t n = ahead.Begin; n < end; n += 4)
+            {
+                Prefetch(&m_Positions[n]);
+                Prefetch(&m_Rotations[n]);
+                Prefetch(&m_Scales[n]);
+            }
+            for (uint32_t n = ahead.Begin; n < end; n++)
+                Prefetch(&m_World[n]);
+            if (m_Parents[ahead.Begin] != InvalidNode)
+                Prefetch(&m_World[m_Parents[ahead.Begin]]);
+        }
+        UpdateRange(ranges[i].Begin, ranges[i].End);
+    }
+}
+
+void SceneGraph::UpdateRange(uint32_t begin, uint32_t end)
+{
+    //parents come earlier and are final already
+    for (uint32_t i = begin; i < end; i++)
+    {
+        uint32_t parent = m_Parents[i];
+        ComposeWorld(parent == InvalidNode ? nullptr : &m_World[parent], m_Positions[i], m_Rotations[i], m_Scales[i], m_World[i]);
+    }
+}
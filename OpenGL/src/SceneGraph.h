@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+typedef uint32_t NodeID;
+static const NodeID InvalidNode = 0xFFFFFFFF;
+
+// Transform hierarchy stored as structure of arrays. Nodes are kept in depth first order, so every parent
+// comes before its children and a subtree is one contiguous range. Setting a local transform only marks the
+// node, Update recomputes the world matrices of the marked subtrees and nothing else, spreading independent
+// subtrees over threads when there is enough work.
+// NodeIDs stay valid while the node lives, dense indices change whenever the hierarchy does.
+class SceneGraph
+{
+private:
+	// by dense index
+	std::vector<glm::vec3>	m_Positions;
+	std::vector<glm::quat>	m_Rotations;
+	std::vector<glm::vec3>	m_Scales;
+	std::vector<glm::mat4>	m_World;
+	std::vector<uint32_t>	m_Parents;		// dense index of the parent, InvalidNode for roots
+	std::vector<uint32_t>	m_SubtreeSizes; // node included
+	std::vector<NodeID>		m_IDs;
+
+	// one bit per dense index, walking the set bits yields the dirty nodes already in order
+	std::vector<uint64_t>	m_DirtyBits;
+	uint32_t				m_DirtyCount;
+
+	std::vector<uint32_t>	m_Indices;	// NodeID -> dense index, InvalidNode if free
+	std::vector<NodeID>		m_FreeIDs;
+	bool					m_OrderDirty; // a node was added or moved out of depth first order
+
+	struct Range
+	{
+		uint32_t Begin, End;
+	};
+	std::vector<Range>		m_Ranges; // scratch for Update, kept to not allocate every frame
+
+public:
+	SceneGraph();
+
+	NodeID Create(NodeID parent = InvalidNode);
+	// Destroys the node and its whole subtree
+	void   Destroy(NodeID node);
+	void   SetParent(NodeID node, NodeID parent);
+
+	void SetPosition(NodeID node, const glm::vec3& position);
+	void SetRotation(NodeID node, const glm::quat& rotation);
+	void SetScale(NodeID node, const glm::vec3& scale);
+
+	inline const glm::vec3& GetPosition(NodeID node) const { return m_Positions[m_Indices[node]]; }
+	inline const glm::quat& GetRotation(NodeID node) const { return m_Rotations[m_Indices[node]]; }
+	inline const glm::vec3& GetScale(NodeID node)	 const { return m_Scales[m_Indices[node]]; }
+	// As of the last Update
+	inline const glm::mat4& GetWorld(NodeID node)	 const { return m_World[m_Indices[node]]; }
+	NodeID GetParent(NodeID node) const;
+
+	// threads = 0 uses every hardware thread, 1 keeps it on the calling thread
+	void Update(unsigned int threads = 0);
+
+	inline unsigned int GetNodeCount() const { return (unsigned int)m_IDs.size(); }
+	// Dense access for systems walking all nodes, valid until the hierarchy changes
+	inline const std::vector<glm::mat4>& GetWorldTransforms() const { return m_World; }
+	inline const std::vector<NodeID>&	 GetNodeIDs()		  const { return m_IDs; }
+
+private:
+	void MarkDirty(uint32_t index);
+	void TakeDirty(std::vector<uint32_t>& indices);
+	void Reorder();
+	void UpdateRanges(const Range* ranges, size_t count);
+	void UpdateRange(uint32_t begin, uint32_t end);
+};
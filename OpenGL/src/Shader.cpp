@@ -4,19 +4,154 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
 
 #include "Renderer.h"
+#include "ShaderCache.h"
+#include "ShaderLibrary.h"
+#include "ShaderPreprocessor.h"
+#include "UniformBuffer.h"
+#include "VertexArray.h"
+#include "VertexBufferLayout.h"
 
-Shader::Shader(const std::string& filepath) : m_FilePath(filepath), m_RendererID(0)
+std::vector<std::pair<std::string, unsigned int>> Shader::s_BlockBindings = {
+    { "Camera", (unsigned int)UniformBinding::Camera },
+    { "Object", (unsigned int)UniformBinding::Object },
+    { "Material", (unsigned int)UniformBinding::Material },
+    { "Culling", (unsigned int)UniformBinding::Culling }
+};
+
+// Number of 4 byte components a uniform of this type holds, samplers and images are a single int
+static unsigned int UniformComponents(GLenum type)
+{
+    switch (type)
+    {
+    case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2:   return 2;
+    case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3:   return 3;
+    case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4:   return 4;
+    case GL_FLOAT_MAT2:                                                                   return 4;
+    case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT3x2:                                           return 6;
+    case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT4x2:                                           return 8;
+    case GL_FLOAT_MAT3:                                                                   return 9;
+    case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x3:                                           return 12;
+    case GL_FLOAT_MAT4:                                                                   return 16;
+    default:                                                                              return 1;
+    }
+}
+
+static bool IsFloatUniform(GLenum type)
+{
+    switch (type)
+    {
+    case GL_FLOAT: case GL_FLOAT_VEC2: case GL_FLOAT_VEC3: case GL_FLOAT_VEC4:
+    case GL_FLOAT_MAT2: case GL_FLOAT_MAT3: case GL_FLOAT_MAT4:
+    case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT3x2:
+    case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x2: case GL_FLOAT_MAT4x3:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool IsUnsignedUniform(GLenum type)
+{
+    return type == GL_UNSIGNED_INT || type == GL_UNSIGNED_INT_VEC2 || type == GL_UNSIGNED_INT_VEC3 || type == GL_UNSIGNED_INT_VEC4;
+}
+
+// Whether a setter writing written may fill a uniform reflected as declared. Ints also go to bools, samplers
+// and images, like glUniform1i; everything else has to match exactly.
+static bool UniformTypeMatches(GLenum written, GLenum declared)
+{
+    if (written == declared)
+        return true;
+    if (written == GL_INT)
+        return UniformComponents(declared) == 1 && !IsFloatUniform(declared) && !IsUnsignedUniform(declared);
+    return false;
+}
+
+// One glUniform* call from a shadow copy, picked by the reflected type
+static void UploadUniform(const UniformInfo& info, const void* data)
+{
+    const float*        f = (const float*)data;
+    const int*          i = (const int*)data;
+    const unsigned int* u = (const unsigned int*)data;
+
+    switch (info.Type)
+    {
+    case GL_FLOAT:             GLCall(glUniform1fv(info.Location, 1, f)); break;
+    case GL_FLOAT_VEC2:        GLCall(glUniform2fv(info.Location, 1, f)); break;
+    case GL_FLOAT_VEC3:        GLCall(glUniform3fv(info.Location, 1, f)); break;
+    case GL_FLOAT_VEC4:        GLCall(glUniform4fv(info.Location, 1, f)); break;
+    case GL_FLOAT_MAT2:        GLCall(glUniformMatrix2fv(info.Location, 1, GL_FALSE, f)); break;
+    case GL_FLOAT_MAT3:        GLCall(glUniformMatrix3fv(info.Location, 1, GL_FALSE, f)); break;
+    case GL_FLOAT_MAT4:        GLCall(glUniformMatrix4fv(info.Location, 1, GL_FALSE, f)); break;
+    case GL_FLOAT_MAT2x3:      GLCall(glUniformMatrix2x3fv(info.Location, 1, GL_FALSE, f)); break;
+    case GL_FLOAT_MAT2x4:      GLCall(glUniformMatrix2x4fv(info.Location, 1, GL_FALSE, f)); break;
+    case GL_FLOAT_MAT3x2:      GLCall(glUniformMatrix3x2fv(info.Location, 1, GL_FALSE, f)); break;
+    case GL_FLOAT_MAT3x4:      GLCall(glUniformMatrix3x4fv(info.Location, 1, GL_FALSE, f)); break;
+    case GL_FLOAT_MAT4x2:      GLCall(glUniformMatrix4x2fv(info.Location, 1, GL_FALSE, f)); break;
+    case GL_FLOAT_MAT4x3:      GLCall(glUniformMatrix4x3fv(info.Location, 1, GL_FALSE, f)); break;
+    case GL_INT_VEC2:          case GL_BOOL_VEC2: GLCall(glUniform2iv(info.Location, 1, i)); break;
+    case GL_INT_VEC3:          case GL_BOOL_VEC3: GLCall(glUniform3iv(info.Location, 1, i)); break;
+    case GL_INT_VEC4:          case GL_BOOL_VEC4: GLCall(glUniform4iv(info.Location, 1, i)); break;
+    case GL_UNSIGNED_INT:      GLCall(glUniform1uiv(info.Location, 1, u)); break;
+    case GL_UNSIGNED_INT_VEC2: GLCall(glUniform2uiv(info.Location, 1, u)); break;
+    case GL_UNSIGNED_INT_VEC3: GLCall(glUniform3uiv(info.Location, 1, u)); break;
+    case GL_UNSIGNED_INT_VEC4: GLCall(glUniform4uiv(info.Location, 1, u)); break;
+    //int, bool, samplers and images
+    default:                   GLCall(glUniform1iv(info.Location, 1, i)); break;
+    }
+}
+
+Shader::Shader(const std::string& filepath, const std::vector<std::string>& defines, bool async)
+    : m_FilePath(filepath), m_Defines(defines), m_RendererID(0), m_PendingID(0)
+{
+    Create(ParseShader(filepath), async);
+}
+
+Shader::Shader(const std::string& filepath, const std::vector<std::string>& defines, const ShaderProgramSource& source, bool async)
+    : m_FilePath(filepath), m_Defines(defines), m_RendererID(0), m_PendingID(0)
+{
+    m_Dependencies = source.Dependencies;
+    Create(source, async);
+}
+
+void Shader::Create(const ShaderProgramSource& source, bool async)
 {
-    ShaderProgramSource source = ParseShader(filepath);
-    //location in shader must match with attribute index
-    m_RendererID = CreateShader(source.VertexSource, source.FragmentSource);
+    //reuse the driver's binary from a previous run if it is still valid, compiling is the slow part of startup
+    m_RendererID = ShaderCache::Load(source);
+    if (!m_RendererID && async)
+    {
+        //stays not ready until Poll sees the link finish
+        m_PendingSource = source;
+        m_PendingID = BeginProgram(source, m_PendingStages);
+        return;
+    }
+
+    if (!m_RendererID)
+    {
+        //location in shader must match with attribute index
+        m_RendererID = CreateShader(source, m_Stages);
+        ShaderCache::Store(m_RendererID, source);
+    }
+
+    ReflectUniforms();
+    ReflectAttributes();
+    BindUniformBlocks();
 }
 
 Shader::~Shader()
 {
+    if (m_PendingID)
+    {
+        FinishProgram(m_PendingID);
+        GLCall(glDeleteProgram(m_PendingID));
+    }
     GLCall(glDeleteProgram(m_RendererID));
+
+    ReleaseStages(m_PendingStages);
+    ReleaseStages(m_Stages);
 }
 
 void Shader::Bind() const
@@ -29,114 +164,487 @@ void Shader::Unbind() const
     GLCall(glUseProgram(0));
 }
 
-void Shader::SetUniform1i(const std::string& name, int value)
+void Shader::Reload()
 {
-    GLCall(glUniform1i(GetUniformLocation(name), value));
+    //a reload still in flight is outdated now, throw it away
+    if (m_PendingID)
+    {
+        FinishProgram(m_PendingID);
+        GLCall(glDeleteProgram(m_PendingID));
+        ReleaseStages(m_PendingStages);
+    }
+
+    m_PendingSource = ParseShader(m_FilePath);
+    m_PendingID = BeginProgram(m_PendingSource, m_PendingStages);
 }
 
-void Shader::SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3)
+bool Shader::Poll()
 {
-    GLCall(glUniform4f(GetUniformLocation(name), v0, v1, v2, v3));
+    if (!m_PendingID || !IsProgramComplete(m_PendingID))
+        return false;
+
+    unsigned int program = m_PendingID;
+    m_PendingID = 0;
+
+    if (!FinishProgram(program))
+    {
+        if (m_RendererID)
+            std::cout << "Reload of " << m_FilePath << " failed, keeping the previous program" << std::endl;
+        GLCall(glDeleteProgram(program));
+        ReleaseStages(m_PendingStages);
+        return false;
+    }
+
+    //the old program's stages are only kept alive for others to share, swap the references along with it
+    ReleaseStages(m_Stages);
+    m_Stages.swap(m_PendingStages);
+
+    //swap at a frame boundary so no draw ever sees a half built program, locations are per program so the table is rebuilt
+    bool reloaded = m_RendererID != 0;
+    GLCall(glDeleteProgram(m_RendererID));
+    m_RendererID = program;
+    ReflectUniforms();
+    ReflectAttributes();
+    BindUniformBlocks();
+
+    ShaderCache::Store(m_RendererID, m_PendingSource);
+    if (reloaded)
+        std::cout << "Reloaded " << m_FilePath << std::endl;
+    return true;
+}
+
+void Shader::SetUniform1i(UniformHandle uniform, int value)
+{
+    WriteUniform(uniform, GL_INT, &value, sizeof(int));
+}
+
+void Shader::SetUniform4f(UniformHandle uniform, float v0, float v1, float v2, float v3)
+{
+    float values[4] = { v0, v1, v2, v3 };
+    WriteUniform(uniform, GL_FLOAT_VEC4, values, sizeof(values));
+}
+
+void Shader::SetUniformMat4f(UniformHandle uniform, const glm::mat4& matrix)
+{
+    WriteUniform(uniform, GL_FLOAT_MAT4, &matrix[0][0], sizeof(glm::mat4));
+}
+
+// Only touches the shadow copy, the value reaches GL in FlushUniforms. Writing what is already there costs a memcmp.
+void Shader::WriteUniform(UniformHandle uniform, unsigned int type, const void* data, unsigned int size)
+{
+    if (uniform.Index == -1)
+        return;
+
+    m_UniformStats.Writes++;
+
+    const UniformInfo& info = m_Uniforms[uniform.Index];
+#ifdef _DEBUG
+    //the shadow copy takes any bytes, a float written to an int would upload garbage without a GL error
+    if (!UniformTypeMatches(type, info.Type))
+    {
+        std::cout << "Uniform " << info.Name << " in " << m_FilePath << " is type 0x" << std::hex << info.Type
+                  << ", written as 0x" << type << std::dec << std::endl;
+        ASSERT(false);
+    }
+#endif
+    unsigned char* shadow = &m_UniformValues[info.Offset];
+    size = std::min(size, info.Size);
+    if (std::memcmp(shadow, data, size) == 0)
+    {
+        m_UniformStats.Elided++;
+        return;
+    }
+
+    std::memcpy(shadow, data, size);
+    if (std::find(m_DirtyUniforms.begin(), m_DirtyUniforms.end(), uniform.Index) == m_DirtyUniforms.end())
+        m_DirtyUniforms.push_back(uniform.Index);
 }
 
-void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& matrix)
+// Uploads every uniform changed since the last flush, the program must be bound
+void Shader::FlushUniforms() const
 {
-    GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0]));
+    for (int index : m_DirtyUniforms)
+    {
+        UploadUniform(m_Uniforms[index], &m_UniformValues[m_Uniforms[index].Offset]);
+        m_UniformStats.Uploads++;
+    }
+    m_DirtyUniforms.clear();
+}
+
+void Shader::Dispatch(unsigned int x, unsigned int y, unsigned int z) const
+{
+    if (!IsReady())
+        return;
+
+    Bind();
+    FlushUniforms();
+    GLCall(glDispatchCompute(x, y, z));
 }
 
 ShaderProgramSource Shader::ParseShader(const std::string& filepath)
 {
-    std::ifstream stream(filepath);
+    ShaderProgramSource source = ShaderPreprocessor::Process(filepath, m_Defines);
+    //includes may have changed since the last parse, so the hot reload watch list follows the newest one
+    m_Dependencies = source.Dependencies;
+    return source;
+}
+
+// Blocking path: provide source code so opengl compiles it and links our shader code into a program and return a unique identifier to said program.
+// Returns 0 if it failed, the shader then never becomes ready.
+unsigned int Shader::CreateShader(const ShaderProgramSource& source, std::vector<unsigned int>& stages)
+{
+    unsigned int program = BeginProgram(source, stages);
+    if (!FinishProgram(program))
+    {
+        GLCall(glDeleteProgram(program));
+        ReleaseStages(stages);
+        return 0;
+    }
+
+    return program;
+}
+
+// Issues compile and link without asking for any status. With KHR_parallel_shader_compile the driver
+// does the work on its own threads and we can keep rendering until IsProgramComplete says it's done.
+// Stages come from ShaderLibrary, so one compiled before from the same source is attached as is.
+unsigned int Shader::BeginProgram(const ShaderProgramSource& source, std::vector<unsigned int>& stages)
+{
+    //let the driver compile on as many threads as it likes, startup and reloads then queue instead of stall
+    static bool s_ThreadsSet = false;
+    if (!s_ThreadsSet && GLEW_KHR_parallel_shader_compile)
+    {
+        GLCall(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+        s_ThreadsSet = true;
+    }
+
+    GLCall(unsigned int program = glCreateProgram());
+
+    if (!source.ComputeSource.empty())
+        stages.push_back(ShaderLibrary::AcquireStage(GL_COMPUTE_SHADER, source.ComputeSource));
+    else
+    {
+        stages.push_back(ShaderLibrary::AcquireStage(GL_VERTEX_SHADER, source.VertexSource));
+        stages.push_back(ShaderLibrary::AcquireStage(GL_FRAGMENT_SHADER, source.FragmentSource));
+    }
+    for (unsigned int stage : stages)
+    {
+        GLCall(glAttachShader(program, stage));
+    }
+
+    if (ShaderCache::IsSupported())
+    {
+        GLCall(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+
+    GLCall(glLinkProgram(program));
+    return program;
+}
+
+void Shader::ReleaseStages(std::vector<unsigned int>& stages)
+{
+    for (unsigned int stage : stages)
+        ShaderLibrary::ReleaseStage(stage);
+    stages.clear();
+}
+
+bool Shader::IsProgramComplete(unsigned int program) const
+{
+    //without the extension any status query blocks anyway, so report done and let FinishProgram wait
+    if (!GLEW_KHR_parallel_shader_compile)
+        return true;
+
+    int complete;
+    GLCall(glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete));
+    return complete == GL_TRUE;
+}
+
+// Prints the logs of whatever failed and detaches the stages, the program itself is left to the caller.
+// The stages stay alive for other programs, ReleaseStages drops our references.
+bool Shader::FinishProgram(unsigned int program)
+{
+    unsigned int shaders[2];
+    int count = 0;
+    GLCall(glGetAttachedShaders(program, 2, &count, shaders));
+
+    for (int i = 0; i < count; i++)
+    {
+        int succ;
+        GLCall(glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &succ));
+        if (succ == GL_FALSE)
+        {
+            int type, ln;
+            GLCall(glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type));
+            GLCall(glGetShaderiv(shaders[i], GL_INFO_LOG_LENGTH, &ln));
 
-    enum class ShaderType
+            std::string message(ln, '\0');
+            GLCall(glGetShaderInfoLog(shaders[i], ln, &ln, &message[0]));
+            const char* name = type == GL_VERTEX_SHADER ? "vertex" : type == GL_FRAGMENT_SHADER ? "fragment" : "compute";
+            std::cout << "Failed to compile " << name << " shader!" << std::endl;
+            std::cout << message << std::endl;
+        }
+
+        GLCall(glDetachShader(program, shaders[i]));
+    }
+
+    int linked;
+    GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+    if (linked == GL_FALSE)
     {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
-    };
+        int ln;
+        GLCall(glGetProgramiv(program, GL_INFO_LOG_LENGTH, &ln));
+
+        std::string message(ln, '\0');
+        GLCall(glGetProgramInfoLog(program, ln, &ln, &message[0]));
+        std::cout << "Failed to link " << m_FilePath << std::endl;
+        std::cout << message << std::endl;
+    }
 
-    std::string line;
-    std::stringstream ss[2]; //one for vertex other for fragment
-    ShaderType type = ShaderType::NONE;
-    while (getline(stream, line))
+#ifdef _DEBUG
+    //validation reports against the current GL state and costs a round trip, release builds skip it
+    if (linked == GL_TRUE)
     {
-        if (line.find("#shader") != std::string::npos)
+        int valid;
+        GLCall(glValidateProgram(program));
+        GLCall(glGetProgramiv(program, GL_VALIDATE_STATUS, &valid));
+        if (valid == GL_FALSE)
         {
-            if (line.find("vertex") != std::string::npos)
-                type = ShaderType::VERTEX;
-            else if (line.find("fragment") != std::string::npos)
-                type = ShaderType::FRAGMENT;
+            int ln;
+            GLCall(glGetProgramiv(program, GL_INFO_LOG_LENGTH, &ln));
+
+            std::string message(ln, '\0');
+            GLCall(glGetProgramInfoLog(program, ln, &ln, &message[0]));
+            std::cout << "Validation of " << m_FilePath << " failed" << std::endl;
+            std::cout << message << std::endl;
         }
-        else
+    }
+#endif
+
+    return linked == GL_TRUE;
+}
+
+void Shader::SetUniformBlockBinding(const std::string& block, unsigned int bindingPoint)
+{
+    for (auto& binding : s_BlockBindings)
+    {
+        if (binding.first == block)
         {
-            ss[(int)type] << line << '\n';
+            binding.second = bindingPoint;
+            return;
         }
     }
+    s_BlockBindings.push_back({ block, bindingPoint });
+}
+
+// Binary search over the reflected table: no strings are built and nothing is allocated per call
+UniformHandle Shader::GetUniform(UniformID name)
+{
+    //nothing is reflected before the program links, dont report uniforms as missing meanwhile
+    if (!m_RendererID)
+        return { -1, -1 };
+
+    auto it = std::lower_bound(m_Uniforms.begin(), m_Uniforms.end(), name.Hash,
+        [](const UniformInfo& info, uint32_t hash) { return info.Hash < hash; });
+    if (it != m_Uniforms.end() && it->Hash == name.Hash)
+        return { it->Location, (int)(it - m_Uniforms.begin()) };
+
+    //only the first miss of every name is reported, after that a missing uniform is as cheap as any other
+    if (std::find(m_MissingUniforms.begin(), m_MissingUniforms.end(), name.Hash) == m_MissingUniforms.end())
+    {
+        std::cout << "Warning: uniform " << name.Name << "' doesn't exist!" << std::endl;
+        m_MissingUniforms.push_back(name.Hash);
+    }
 
-    return { ss[0].str(), ss[1].str() };
+    return { -1, -1 };
 }
 
-// compile shader function to avoid code duplication
-// type is a GLEnum but well use its equivalent to avoid openGl built in types
-unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
+// Builds the uniform table once per linked program
+void Shader::ReflectUniforms()
 {
-    GLCall(unsigned int id = glCreateShader(type));
-    const char* src = source.c_str();
+    //values set on the previous program are carried over, so a hot reload keeps what the application set
+    std::vector<UniformInfo>   previousUniforms;
+    std::vector<unsigned char> previousValues;
+    previousUniforms.swap(m_Uniforms);
+    previousValues.swap(m_UniformValues);
 
-    GLCall(glShaderSource(id, 1, &src, nullptr));
+    m_MissingUniforms.clear();
+    m_DirtyUniforms.clear();
 
-    GLCall(glCompileShader(id));
+    int count = 0, maxLength = 0;
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORMS, &count));
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
 
-    int succ;
-    GLCall(glGetShaderiv(id, GL_COMPILE_STATUS, &succ));
-    if (succ == GL_FALSE)
+    std::string name(maxLength, '\0');
+    for (int i = 0; i < count; i++)
     {
-        int ln;
-        GLCall(glGetShaderiv(id, GL_INFO_LOG_LENGTH, &ln));
+        int length, size;
+        GLenum type;
+        GLCall(glGetActiveUniform(m_RendererID, i, maxLength, &length, &size, &type, &name[0]));
 
-        char* message = (char*)alloca(ln * sizeof(char)); //since ln is variable we need alloca to still keep this cariable on the stack dynamicaly
-        GLCall(glGetShaderInfoLog(id, ln, &ln, message));
-        std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader!" << std::endl;
-        std::cout << message << std::endl;
+        std::string uniformName = name.substr(0, length);
+        GLCall(int location = glGetUniformLocation(m_RendererID, uniformName.c_str()));
+        //members of uniform blocks have no location, they are set through the buffer
+        if (location == -1)
+            continue;
 
-        GLCall(glDeleteShader(id));
-        return 0;
+        //arrays are reported as "name[0]", look them up by their plain name
+        size_t bracket = uniformName.find('[');
+        if (bracket != std::string::npos)
+            uniformName.erase(bracket);
+
+        m_Uniforms.push_back({ UniformHash(uniformName.c_str()), location, type, size, 0, UniformComponents(type) * 4, uniformName });
     }
 
-    return id;
+    std::sort(m_Uniforms.begin(), m_Uniforms.end(), [](const UniformInfo& a, const UniformInfo& b) { return a.Hash < b.Hash; });
+
+    for (size_t i = 1; i < m_Uniforms.size(); i++)
+        if (m_Uniforms[i].Hash == m_Uniforms[i - 1].Hash)
+            std::cout << "Warning: uniforms " << m_Uniforms[i - 1].Name << " and " << m_Uniforms[i].Name << " have the same hash in " << m_FilePath << std::endl;
+
+    //arrays only shadow their first element, that's all the setters write
+    unsigned int offset = 0;
+    for (UniformInfo& info : m_Uniforms)
+    {
+        info.Offset = offset;
+        offset += info.Size;
+    }
+    m_UniformValues.assign(offset, 0);
+
+    for (int i = 0; i < (int)m_Uniforms.size(); i++)
+    {
+        UniformInfo& info = m_Uniforms[i];
+        void* shadow = &m_UniformValues[info.Offset];
+
+        auto previous = std::lower_bound(previousUniforms.begin(), previousUniforms.end(), info.Hash,
+            [](const UniformInfo& other, uint32_t hash) { return other.Hash < hash; });
+        if (previous != previousUniforms.end() && previous->Hash == info.Hash && previous->Type == info.Type)
+        {
+            std::memcpy(shadow, &previousValues[previous->Offset], info.Size);
+            m_DirtyUniforms.push_back(i);
+            continue;
+        }
+
+        //start from what the program holds, defaults from initializers included
+        if (IsFloatUniform(info.Type))
+        {
+            GLCall(glGetUniformfv(m_RendererID, info.Location, (float*)shadow));
+        }
+        else if (IsUnsignedUniform(info.Type))
+        {
+            GLCall(glGetUniformuiv(m_RendererID, info.Location, (unsigned int*)shadow));
+        }
+        else
+        {
+            GLCall(glGetUniformiv(m_RendererID, info.Location, (int*)shadow));
+        }
+    }
+
+    //every uniform can be dirty at once, so setting them never grows the list mid frame
+    m_DirtyUniforms.reserve(m_Uniforms.size());
 }
 
-// Function to compile shaders (static so it doesnt leak into other translation units (+/- cpp files)
-// provide source code so opengl compiles it and links our shader code into a shader and return a unique identifier to sayd shader
-unsigned int Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader)
+// GLSL 330 has no layout(binding=N), so the block -> binding point mapping is set here after every link
+void Shader::BindUniformBlocks()
 {
-    GLCall(unsigned int program = glCreateProgram());
-    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+    for (const auto& binding : s_BlockBindings)
+    {
+        GLCall(unsigned int index = glGetUniformBlockIndex(m_RendererID, binding.first.c_str()));
+        if (index != GL_INVALID_INDEX)
+        {
+            GLCall(glUniformBlockBinding(m_RendererID, index, binding.second));
+        }
+    }
+}
 
-    GLCall(glAttachShader(program, vs));
-    GLCall(glAttachShader(program, fs));
+// Attribute locations are per program too, so every link starts with an empty mapping cache
+void Shader::ReflectAttributes()
+{
+    m_Attributes.clear();
+    m_AttributeLocations.clear();
+    m_ReportedLayouts.clear();
 
-    GLCall(glLinkProgram(program));
+    int count = 0, maxLength = 0;
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_ATTRIBUTES, &count));
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength));
 
-    GLCall(glValidateProgram(program));
+    std::string name(maxLength, '\0');
+    for (int i = 0; i < count; i++)
+    {
+        int length, size;
+        GLenum type;
+        GLCall(glGetActiveAttrib(m_RendererID, i, maxLength, &length, &size, &type, &name[0]));
 
-    //we can delete intermediate shaders since they are already linked into a program
-    GLCall(glDeleteShader(vs));
-    GLCall(glDeleteShader(fs));
+        std::string attributeName = name.substr(0, length);
+        GLCall(int location = glGetAttribLocation(m_RendererID, attributeName.c_str()));
+        //built-ins like gl_VertexID are active but not fed by buffers
+        if (location == -1)
+            continue;
 
-    return program;
+        m_Attributes.push_back({ location, type, size, attributeName });
+    }
+}
+
+const std::vector<int>& Shader::GetAttributeLocations(const VertexBufferLayout& layout) const
+{
+    auto it = m_AttributeLocations.find(layout.GetHash());
+    if (it != m_AttributeLocations.end())
+        return it->second;
+
+    std::vector<std::string> names;
+    for (const auto& element : layout.GetElements())
+        names.push_back(element.name);
+    return MapAttributes(layout.GetHash(), names);
 }
 
-int Shader::GetUniformLocation(const std::string& name)
+bool Shader::CanDraw(const VertexArray& va) const
 {
-    if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
-        return m_UniformLocationCache[name];
+    //nothing was specified through AddBuffer, nothing to compare against
+    if (va.GetAttributeNames().empty())
+        return true;
+
+    auto it = m_AttributeLocations.find(va.GetLayoutHash());
+    const std::vector<int>& expected = it != m_AttributeLocations.end() ? it->second : MapAttributes(va.GetLayoutHash(), va.GetAttributeNames());
+    const std::vector<int>& actual = va.GetLocations();
 
-    GLCall(int location = glGetUniformLocation(m_RendererID, name.c_str()));
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        //an element the program doesn't read can sit anywhere
+        if (expected[i] == -1 || expected[i] == actual[i])
+            continue;
 
-    if (location == -1)
-        std::cout << "Warning: uniform " << name << "' doesn't exist!" << std::endl;
-        
-    m_UniformLocationCache[name] = location;
+        if (std::find(m_ReportedLayouts.begin(), m_ReportedLayouts.end(), va.GetLayoutHash()) == m_ReportedLayouts.end())
+        {
+            std::cout << "Warning: vertex array feeds '" << va.GetAttributeNames()[i] << "' at location " << actual[i]
+                      << " but " << m_FilePath << " reads it from " << expected[i] << std::endl;
+            m_ReportedLayouts.push_back(va.GetLayoutHash());
+        }
+        return false;
+    }
+    return true;
+}
+
+const std::vector<int>& Shader::MapAttributes(uint64_t layoutHash, const std::vector<std::string>& names) const
+{
+    std::vector<int> locations(names.size(), -1);
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        //unnamed elements keep the old implicit rule: element i is location i
+        if (names[i].empty())
+        {
+            locations[i] = (int)i;
+            continue;
+        }
+
+        auto attribute = std::find_if(m_Attributes.begin(), m_Attributes.end(), [&](const AttributeInfo& info) { return info.Name == names[i]; });
+        if (attribute != m_Attributes.end())
+            locations[i] = attribute->Location;
+    }
+
+    //an input nothing feeds reads a constant, that's almost always a typo in a name
+    for (const AttributeInfo& attribute : m_Attributes)
+    {
+        if (std::find(locations.begin(), locations.end(), attribute.Location) == locations.end())
+            std::cout << "Warning: attribute '" << attribute.Name << "' of " << m_FilePath << " is not fed by the vertex layout" << std::endl;
+    }
 
-	return location;
+    return m_AttributeLocations[layoutHash] = locations;
 }
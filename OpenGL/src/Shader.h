@@ -1,7 +1,9 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <unordered_map>
+#include <cstdint>
 
 #include "glm/glm.hpp"
 
@@ -9,31 +11,167 @@ struct ShaderProgramSource
 {
 	std::string VertexSource;
 	std::string FragmentSource;
+	std::string ComputeSource; // if set the program is a compute program and the other stages are empty
+	std::vector<std::string> Dependencies; // every file that was read, the .shader itself first
+	std::vector<std::string> Features;	   // keywords declared with #feature
 };
 
+// FNV-1a over a uniform name, constexpr so names known at compile time cost nothing at runtime
+constexpr uint32_t UniformHash(const char* name)
+{
+	uint32_t hash = 2166136261u;
+	while (*name)
+	{
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// Uniform name as passed to SetUniform*. Hashes the string in place, so passing a literal never allocates;
+// declare it constexpr (constexpr UniformID id("u_MVP")) to hash at compile time
+struct UniformID
+{
+	uint32_t	Hash;
+	const char* Name; // only used for warnings, not owned
+
+	constexpr UniformID(const char* name) : Hash(UniformHash(name)), Name(name) {}
+	UniformID(const std::string& name) : Hash(UniformHash(name.c_str())), Name(name.c_str()) {}
+};
+
+// Location resolved once with Shader::GetUniform, valid until the program is reloaded
+struct UniformHandle
+{
+	int Location;
+	int Index; // into the reflected table, -1 if the uniform doesn't exist
+};
+
+// One active uniform of the linked program, reflected with glGetActiveUniform
+struct UniformInfo
+{
+	uint32_t	 Hash;
+	int			 Location;
+	unsigned int Type;
+	int			 Count;
+	unsigned int Offset; // of the shadow copy in the shader's value buffer
+	unsigned int Size;	 // bytes shadowed, one element for arrays
+	std::string	 Name;
+};
+
+// One active vertex input of the linked program, reflected with glGetActiveAttrib
+struct AttributeInfo
+{
+	int			 Location;
+	unsigned int Type;
+	int			 Count;
+	std::string	 Name;
+};
+
+// Counted since the last ResetUniformStats. Elided writes matched the shadow copy and never reached GL.
+struct UniformStats
+{
+	unsigned int Writes;
+	unsigned int Elided;
+	unsigned int Uploads;
+};
+
+class VertexArray;
+class VertexBufferLayout;
+
 class Shader
 {
 private:
 	std::string  m_FilePath;
+	std::vector<std::string> m_Defines;
+	std::vector<std::string> m_Dependencies;
 	unsigned int m_RendererID;
-	// caching for uniforms
-	std::unordered_map<std::string, int> m_UniformLocationCache;
+	unsigned int m_PendingID; // program still compiling, from Reload or an async create, 0 if none
+	ShaderProgramSource m_PendingSource;
+	// compiled stages we hold a ShaderLibrary reference to, for the current and the pending program
+	std::vector<unsigned int> m_Stages;
+	std::vector<unsigned int> m_PendingStages;
+	// active uniforms sorted by name hash, rebuilt whenever a program is linked
+	std::vector<UniformInfo> m_Uniforms;
+	std::vector<uint32_t>	 m_MissingUniforms; // already warned about
+	// CPU copies of every uniform value, SetUniform* write here and FlushUniforms sends what changed
+	std::vector<unsigned char> m_UniformValues;
+	mutable std::vector<int>   m_DirtyUniforms;
+	mutable UniformStats	   m_UniformStats = {};
+	std::vector<AttributeInfo> m_Attributes;
+	// layout hash -> attribute location of every layout element (-1 if unused), computed once per program
+	mutable std::unordered_map<uint64_t, std::vector<int>> m_AttributeLocations;
+	mutable std::vector<uint64_t> m_ReportedLayouts; // mismatches already warned about
+
+	// uniform block name -> binding point, applied to every program that declares the block
+	static std::vector<std::pair<std::string, unsigned int>> s_BlockBindings;
 public:
-	Shader(const std::string& filepath);
+	// defines select the permutation: NAME or NAME=VALUE, see ShaderPreprocessor
+	// async only queues compile and link, the shader is not ready until Poll finishes it
+	Shader(const std::string& filepath, const std::vector<std::string>& defines = {}, bool async = false);
+	// for sources that were already preprocessed, e.g. on a worker thread
+	Shader(const std::string& filepath, const std::vector<std::string>& defines, const ShaderProgramSource& source, bool async = false);
 	~Shader();
 
 	void Bind()   const;
 	void Unbind() const;
 
-	//Set Uniformsconst
-	void SetUniform1i(const std::string& name, int value);
-	void SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3);
-	void SetUniformMat4f(const std::string& name, const glm::mat4& matrix);
+	// Hot reload: re-reads the file and starts compiling it, the current program stays in use meanwhile
+	void Reload();
+	// Call once per frame, returns true when a pending reload or async create linked and the program was swapped in.
+	// A reload that fails to compile is dropped and the old program kept.
+	bool Poll();
+
+	// False while an async create is compiling or if it failed, the renderer skips or substitutes such shaders
+	inline bool IsReady()	const { return m_RendererID != 0; }
+	inline bool IsPending() const { return m_PendingID != 0; }
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline const std::vector<std::string>& GetDefines()		 const { return m_Defines; }
+	inline const std::vector<std::string>& GetDependencies() const { return m_Dependencies; }
+
+	// Every program linked afterwards connects its block with this name to bindingPoint
+	static void SetUniformBlockBinding(const std::string& block, unsigned int bindingPoint);
+
+	UniformHandle GetUniform(UniformID name);
+	inline const std::vector<UniformInfo>& GetUniforms() const { return m_Uniforms; }
+
+	//Set Uniforms
+	void SetUniform1i(UniformID name, int value)									{ SetUniform1i(GetUniform(name), value); }
+	void SetUniform4f(UniformID name, float v0, float v1, float v2, float v3)	{ SetUniform4f(GetUniform(name), v0, v1, v2, v3); }
+	void SetUniformMat4f(UniformID name, const glm::mat4& matrix)				{ SetUniformMat4f(GetUniform(name), matrix); }
+
+	void SetUniform1i(UniformHandle uniform, int value);
+	void SetUniform4f(UniformHandle uniform, float v0, float v1, float v2, float v3);
+	void SetUniformMat4f(UniformHandle uniform, const glm::mat4& matrix);
+
+	// Setters are deferred, Renderer::Draw calls this after binding. Call it yourself when drawing without the Renderer.
+	void FlushUniforms() const;
+
+	// Compute programs only: binds, flushes and runs x * y * z work groups. Issue the glMemoryBarrier the consumer needs.
+	void Dispatch(unsigned int x, unsigned int y = 1, unsigned int z = 1) const;
+
+	inline const UniformStats& GetUniformStats() const { return m_UniformStats; }
+	inline void ResetUniformStats() { m_UniformStats = {}; }
+
+	inline const std::vector<AttributeInfo>& GetAttributes() const { return m_Attributes; }
+	// Location of the attribute each layout element feeds, matched by name. Unnamed elements keep their index.
+	const std::vector<int>& GetAttributeLocations(const VertexBufferLayout& layout) const;
+	// True if the VAO's attributes sit where this program reads them, warns once per layout if not
+	bool CanDraw(const VertexArray& va) const;
 
 private:
+	void				Create(const ShaderProgramSource& source, bool async);
 	ShaderProgramSource ParseShader(const std::string& filepath);
-	int					GetUniformLocation(const std::string& name);
-	unsigned int		CompileShader(unsigned int type, const std::string& source);
-	unsigned int		CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
+	void				ReflectUniforms();
+	void				ReflectAttributes();
+	const std::vector<int>& MapAttributes(uint64_t layoutHash, const std::vector<std::string>& names) const;
+	void				WriteUniform(UniformHandle uniform, unsigned int type, const void* data, unsigned int size);
+	void				BindUniformBlocks();
+	unsigned int		CreateShader(const ShaderProgramSource& source, std::vector<unsigned int>& stages);
+	unsigned int		BeginProgram(const ShaderProgramSource& source, std::vector<unsigned int>& stages);
+	void				ReleaseStages(std::vector<unsigned int>& stages);
+	bool				IsProgramComplete(unsigned int program) const;
+	bool				FinishProgram(unsigned int program);
 };
 
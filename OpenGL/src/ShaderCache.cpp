@@ -0,0 +1,176 @@
+#include "ShaderCache.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "Renderer.h"
+
+static const char		  s_Magic[4] = { 'G', 'L', 'P', 'B' };
+static const unsigned int s_Version	 = 1;
+
+std::string ShaderCache::s_Directory = "shadercache";
+
+bool ShaderCache::IsSupported()
+{
+	if (!GLEW_ARB_get_program_binary)
+		return false;
+
+	//Some drivers expose the extension but support no formats at all
+	GLint formats = 0;
+	GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+	return formats > 0;
+}
+
+unsigned int ShaderCache::Load(const ShaderProgramSource& source)
+{
+	if (!IsSupported())
+		return 0;
+
+	std::string key	 = GetKey(source);
+	std::string path = GetPath(key);
+
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream)
+		return 0;
+
+	char		 magic[4];
+	unsigned int version = 0, keyLength = 0, binaryFormat = 0, binaryLength = 0;
+	stream.read(magic, 4);
+	stream.read((char*)&version, sizeof(version));
+	stream.read((char*)&keyLength, sizeof(keyLength));
+
+	//Two different keys can land on the same file name, compare the full key before trusting the binary
+	std::string storedKey(stream ? keyLength : 0, '\0');
+	stream.read(&storedKey[0], storedKey.size());
+	stream.read((char*)&binaryFormat, sizeof(binaryFormat));
+	stream.read((char*)&binaryLength, sizeof(binaryLength));
+
+	std::vector<char> binary(stream ? binaryLength : 0);
+	stream.read(binary.data(), binary.size());
+
+	bool valid = stream && std::equal(magic, magic + 4, s_Magic) && version == s_Version && storedKey == key;
+	stream.close();
+	if (!valid)
+	{
+		std::remove(path.c_str());
+		return 0;
+	}
+
+	GLCall(unsigned int program = glCreateProgram());
+	GLCall(glProgramBinary(program, binaryFormat, binary.data(), (GLsizei)binary.size()));
+
+	//The driver is free to reject a binary it wrote itself, e.g. after an update that kept the version string
+	int linked;
+	GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+	if (linked == GL_FALSE)
+	{
+		std::cout << "Warning: discarding stale program binary " << path << std::endl;
+		GLCall(glDeleteProgram(program));
+		std::remove(path.c_str());
+		return 0;
+	}
+
+	return program;
+}
+
+void ShaderCache::Store(unsigned int program, const ShaderProgramSource& source)
+{
+	if (!program || !IsSupported())
+		return;
+
+	int linked, length;
+	GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+	GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+	if (linked == GL_FALSE || length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum binaryFormat;
+	GLCall(glGetProgramBinary(program, length, &length, &binaryFormat, binary.data()));
+
+#ifdef _WIN32
+	_mkdir(s_Directory.c_str());
+#else
+	mkdir(s_Directory.c_str(), 0755);
+#endif
+
+	std::string key	 = GetKey(source);
+	std::string path = GetPath(key);
+
+	//Write to a temporary first so a crash mid write never leaves a truncated entry behind
+	std::string temp = path + ".tmp";
+	{
+		std::ofstream stream(temp, std::ios::binary | std::ios::trunc);
+		if (!stream)
+			return;
+
+		unsigned int keyLength = (unsigned int)key.size(), format = binaryFormat, binaryLength = (unsigned int)length;
+		stream.write(s_Magic, 4);
+		stream.write((const char*)&s_Version, sizeof(s_Version));
+		stream.write((const char*)&keyLength, sizeof(keyLength));
+		stream.write(key.data(), key.size());
+		stream.write((const char*)&format, sizeof(format));
+		stream.write((const char*)&binaryLength, sizeof(binaryLength));
+		stream.write(binary.data(), length);
+		if (!stream)
+		{
+			stream.close();
+			std::remove(temp.c_str());
+			return;
+		}
+	}
+
+	std::remove(path.c_str()); // rename doesnt overwrite on windows
+	if (std::rename(temp.c_str(), path.c_str()) != 0)
+		std::remove(temp.c_str());
+}
+
+void ShaderCache::SetDirectory(const std::string& directory)
+{
+	s_Directory = directory;
+}
+
+uint64_t ShaderCache::Hash(const std::string& data, uint64_t seed)
+{
+	uint64_t hash = seed;
+	for (unsigned char c : data)
+	{
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+std::string ShaderCache::GetKey(const ShaderProgramSource& source)
+{
+	GLCall(const char* vendor	= (const char*)glGetString(GL_VENDOR));
+	GLCall(const char* renderer = (const char*)glGetString(GL_RENDERER));
+	GLCall(const char* version	= (const char*)glGetString(GL_VERSION));
+
+	uint64_t hash = Hash(source.VertexSource);
+	hash = Hash(std::string(1, '\0'), hash);
+	hash = Hash(source.FragmentSource, hash);
+	hash = Hash(std::string(1, '\0'), hash);
+	hash = Hash(source.ComputeSource, hash);
+
+	std::stringstream ss;
+	ss << (vendor ? vendor : "") << '|' << (renderer ? renderer : "") << '|' << (version ? version : "") << '|' << std::hex << hash;
+	return ss.str();
+}
+
+std::string ShaderCache::GetPath(const std::string& key)
+{
+	std::stringstream ss;
+	ss << s_Directory << '/' << std::hex << Hash(key) << ".bin";
+	return ss.str();
+}
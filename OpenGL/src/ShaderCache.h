@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "Shader.h"
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+// Entries are keyed by a hash of the sources plus the driver vendor, renderer and version,
+// so a driver update or an edited shader simply misses the cache and recompiles.
+class ShaderCache
+{
+private:
+	static std::string s_Directory;
+
+public:
+	static bool IsSupported();
+
+	// Returns a linked program or 0 on a miss, in which case the caller compiles from source
+	static unsigned int Load(const ShaderProgramSource& source);
+	static void			Store(unsigned int program, const ShaderProgramSource& source);
+
+	static void SetDirectory(const std::string& directory);
+
+	// FNV-1a, stable across runs and platforms unlike std::hash
+	static uint64_t Hash(const std::string& data, uint64_t seed = 14695981039346656037ull);
+
+private:
+	static std::string GetKey(const ShaderProgramSource& source);
+	static std::string GetPath(const std::string& key);
+};
@@ -0,0 +1,39 @@
+#include "ShaderHotReload.h"
+
+#include <algorithm>
+
+#include "Shader.h"
+
+void ShaderHotReload::Add(Shader& shader)
+{
+    m_Shaders.push_back(&shader);
+    for (const std::string& dependency : shader.GetDependencies())
+        m_Watcher.Watch(dependency);
+}
+
+void ShaderHotReload::Remove(Shader& shader)
+{
+    m_Shaders.erase(std::remove(m_Shaders.begin(), m_Shaders.end(), &shader), m_Shaders.end());
+}
+
+void ShaderHotReload::Update()
+{
+    //an edited include reloads every shader that pulls it in
+    for (const std::string& path : m_Watcher.Poll())
+    {
+        for (Shader* shader : m_Shaders)
+        {
+            const std::vector<std::string>& dependencies = shader->GetDependencies();
+            if (std::find(dependencies.begin(), dependencies.end(), path) == dependencies.end())
+                continue;
+
+            shader->Reload();
+            //the edit may have added includes
+            for (const std::string& dependency : shader->GetDependencies())
+                m_Watcher.Watch(dependency);
+        }
+    }
+
+    for (Shader* shader : m_Shaders)
+        shader->Poll();
+}
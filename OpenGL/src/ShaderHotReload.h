@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+#include "FileWatcher.h"
+
+class Shader;
+
+// Watches the files of the registered shaders, includes too, and reloads them when they change on disk.
+// Call Update once per frame from the thread owning the GL context.
+class ShaderHotReload
+{
+private:
+	FileWatcher			 m_Watcher;
+	std::vector<Shader*> m_Shaders;
+
+public:
+	void Add(Shader& shader);
+	void Remove(Shader& shader);
+
+	void Update();
+};
@@ -0,0 +1,88 @@
+#include "ShaderLibrary.h"
+
+#include <algorithm>
+
+#include "Renderer.h"
+#include "ShaderCache.h"
+#include "ShaderPreprocessor.h"
+
+std::unordered_map<uint64_t, ShaderLibrary::Stage> ShaderLibrary::s_Stages;
+
+std::shared_ptr<Shader> ShaderLibrary::Load(const std::string& filepath, const std::vector<std::string>& defines, bool async)
+{
+    ShaderProgramSource source = ShaderPreprocessor::Process(filepath, defines);
+    uint64_t hash = HashSource(source.ComputeSource, HashSource(source.FragmentSource, HashSource(source.VertexSource)));
+
+    auto it = m_Programs.find(hash);
+    if (it != m_Programs.end())
+    {
+        if (std::shared_ptr<Shader> shader = it->second.lock())
+            return shader;
+    }
+
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>(filepath, defines, source, async);
+    m_Programs[hash] = shader;
+    return shader;
+}
+
+unsigned int ShaderLibrary::GetProgramCount() const
+{
+    return (unsigned int)std::count_if(m_Programs.begin(), m_Programs.end(),
+        [](const std::pair<const uint64_t, std::weak_ptr<Shader>>& program) { return !program.second.expired(); });
+}
+
+uint64_t ShaderLibrary::HashSource(const std::string& source, uint64_t seed)
+{
+    uint64_t hash = seed;
+    size_t start = 0;
+    while (start < source.size())
+    {
+        size_t end = source.find('\n', start);
+        if (end == std::string::npos)
+            end = source.size();
+
+        //"\r" and trailing blanks dont change what the compiler sees. An empty line at 0 would make end - 1 npos
+        if (end > start)
+        {
+            size_t last = source.find_last_not_of(" \t\r", end - 1);
+            if (last != std::string::npos && last >= start)
+                hash = ShaderCache::Hash(source.substr(start, last - start + 1) + '\n', hash);
+        }
+
+        start = end + 1;
+    }
+    return hash;
+}
+
+unsigned int ShaderLibrary::AcquireStage(unsigned int type, const std::string& source)
+{
+    uint64_t hash = HashSource(source, ShaderCache::Hash(std::to_string(type)));
+
+    auto it = s_Stages.find(hash);
+    if (it != s_Stages.end())
+    {
+        it->second.References++;
+        return it->second.ID;
+    }
+
+    GLCall(unsigned int id = glCreateShader(type));
+    const char* src = source.c_str();
+    GLCall(glShaderSource(id, 1, &src, nullptr));
+    GLCall(glCompileShader(id));
+
+    s_Stages[hash] = { id, 1 };
+    return id;
+}
+
+void ShaderLibrary::ReleaseStage(unsigned int stage)
+{
+    auto it = std::find_if(s_Stages.begin(), s_Stages.end(), [stage](const std::pair<const uint64_t, Stage>& entry) { return entry.second.ID == stage; });
+    if (it == s_Stages.end())
+        return;
+
+    if (--it->second.References == 0)
+    {
+        GLCall(glDeleteShader(stage));
+        s_Stages.erase(it);
+    }
+}
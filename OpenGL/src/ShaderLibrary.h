@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+#include "Shader.h"
+
+// Hands out one shared Shader per distinct preprocessed source, so loading the same file (or two files that
+// expand to the same code) twice links a single program. Below that, compiled stages are shared by every
+// Shader: a vertex shader common to many programs is compiled once and attached to each of them.
+class ShaderLibrary
+{
+private:
+	// canonical source hash -> program, entries expire with the last user
+	std::unordered_map<uint64_t, std::weak_ptr<Shader>> m_Programs;
+
+	struct Stage
+	{
+		unsigned int ID;
+		unsigned int References;
+	};
+	static std::unordered_map<uint64_t, Stage> s_Stages;
+
+public:
+	std::shared_ptr<Shader> Load(const std::string& filepath, const std::vector<std::string>& defines = {}, bool async = false);
+
+	// Programs still in use
+	unsigned int GetProgramCount() const;
+
+	// Hash that ignores line endings, trailing whitespace and blank lines
+	static uint64_t HashSource(const std::string& source, uint64_t seed = 14695981039346656037ull);
+
+	// Compiles a stage or returns the one already compiled from the same source, without waiting for the compile.
+	// Every Acquire needs a matching Release, the stage is deleted with its last reference.
+	static unsigned int AcquireStage(unsigned int type, const std::string& source);
+	static void			ReleaseStage(unsigned int stage);
+	static unsigned int GetStageCount() { return (unsigned int)s_Stages.size(); }
+};
@@ -0,0 +1,95 @@
+#include "ShaderPermutations.h"
+
+#include <algorithm>
+#include <future>
+
+#include "ShaderCache.h"
+#include "ShaderPreprocessor.h"
+
+ShaderPermutations::ShaderPermutations(const std::string& filepath)
+    : m_FilePath(filepath), m_Features(ShaderPreprocessor::Process(filepath).Features)
+{
+}
+
+Shader& ShaderPermutations::Get(const std::vector<std::string>& defines)
+{
+    std::vector<std::string> canonical = Canonicalize(defines);
+    uint64_t hash = HashDefines(canonical);
+
+    auto it = m_Variants.find(hash);
+    if (it != m_Variants.end())
+        return *it->second;
+
+    std::unique_ptr<Shader>& shader = m_Variants[hash];
+    shader = std::make_unique<Shader>(m_FilePath, canonical);
+    return *shader;
+}
+
+void ShaderPermutations::Warm(const std::vector<std::vector<std::string>>& defineSets)
+{
+    struct Pending
+    {
+        uint64_t							Hash;
+        std::vector<std::string>			Defines;
+        std::future<ShaderProgramSource>	Source;
+    };
+
+    //File reads and include expansion need no GL context, so they run on worker threads
+    std::vector<Pending> pending;
+    for (const auto& defines : defineSets)
+    {
+        std::vector<std::string> canonical = Canonicalize(defines);
+        uint64_t hash = HashDefines(canonical);
+
+        bool queued = std::any_of(pending.begin(), pending.end(), [hash](const Pending& p) { return p.Hash == hash; });
+        if (queued || m_Variants.count(hash))
+            continue;
+
+        std::string filepath = m_FilePath;
+        pending.push_back({ hash, canonical, std::async(std::launch::async, [filepath, canonical]() { return ShaderPreprocessor::Process(filepath, canonical); }) });
+    }
+
+    for (Pending& p : pending)
+        m_Variants[p.Hash] = std::make_unique<Shader>(m_FilePath, p.Defines, p.Source.get(), true);
+}
+
+unsigned int ShaderPermutations::Poll()
+{
+    unsigned int pending = 0;
+    for (auto& variant : m_Variants)
+    {
+        variant.second->Poll();
+        if (variant.second->IsPending())
+            pending++;
+    }
+    return pending;
+}
+
+bool ShaderPermutations::IsReady() const
+{
+    return std::none_of(m_Variants.begin(), m_Variants.end(),
+        [](const std::pair<const uint64_t, std::unique_ptr<Shader>>& variant) { return variant.second->IsPending(); });
+}
+
+std::vector<std::string> ShaderPermutations::Canonicalize(const std::vector<std::string>& defines) const
+{
+    std::vector<std::string> canonical;
+    for (const std::string& define : defines)
+    {
+        std::string name = define.substr(0, define.find('='));
+        if (m_Features.empty() || std::find(m_Features.begin(), m_Features.end(), name) != m_Features.end())
+            canonical.push_back(define);
+    }
+
+    std::sort(canonical.begin(), canonical.end());
+    canonical.erase(std::unique(canonical.begin(), canonical.end()), canonical.end());
+    return canonical;
+}
+
+uint64_t ShaderPermutations::HashDefines(const std::vector<std::string>& defines)
+{
+    uint64_t hash = ShaderCache::Hash("");
+    for (const std::string& define : defines)
+        hash = ShaderCache::Hash(define + '\n', hash);
+    return hash;
+}
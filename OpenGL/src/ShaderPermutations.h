@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+#include "Shader.h"
+
+// All variants of one .shader file, compiled on first use and cached by the hash of their define set.
+// Defines that the file doesnt declare with #feature are dropped, so they cant multiply the variants.
+class ShaderPermutations
+{
+private:
+	std::string												m_FilePath;
+	std::vector<std::string>								m_Features;
+	std::unordered_map<uint64_t, std::unique_ptr<Shader>>	m_Variants;
+
+public:
+	ShaderPermutations(const std::string& filepath);
+
+	// Order and duplicates dont matter, {"A", "B"} and {"B", "A", "A"} are the same variant
+	Shader& Get(const std::vector<std::string>& defines = {});
+
+	// Queues the given variants up front: preprocessing runs in parallel and all programs compile
+	// on the driver's threads, call Poll every frame until IsReady
+	void Warm(const std::vector<std::vector<std::string>>& defineSets);
+	// Finishes variants whose link completed, returns how many are still pending
+	unsigned int Poll();
+	bool IsReady() const;
+
+	inline const std::vector<std::string>& GetFeatures() const { return m_Features; }
+	inline unsigned int GetVariantCount() const { return (unsigned int)m_Variants.size(); }
+
+private:
+	std::vector<std::string> Canonicalize(const std::vector<std::string>& defines) const;
+	static uint64_t			 HashDefines(const std::vector<std::string>& defines);
+};
@@ -0,0 +1,106 @@
+#include "ShaderPreprocessor.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+ShaderProgramSource ShaderPreprocessor::Process(const std::string& filepath, const std::vector<std::string>& defines)
+{
+    ShaderProgramSource source;
+
+    Context context;
+    context.Defines = &defines;
+    context.Source	= &source;
+    context.Stage	= -1;
+
+    if (!Append(context, filepath))
+        std::cout << "Failed to open shader " << filepath << std::endl;
+
+    source.VertexSource	  = context.Stages[0].str();
+    source.FragmentSource = context.Stages[1].str();
+    source.ComputeSource  = context.Stages[2].str();
+    return source;
+}
+
+bool ShaderPreprocessor::Append(Context& context, const std::string& filepath)
+{
+    std::ifstream stream(filepath);
+    if (!stream)
+        return false;
+
+    if (std::find(context.Source->Dependencies.begin(), context.Source->Dependencies.end(), filepath) == context.Source->Dependencies.end())
+        context.Source->Dependencies.push_back(filepath);
+
+    std::string line;
+    while (getline(stream, line))
+    {
+        size_t start = line.find_first_not_of(" \t");
+        std::string directive = start == std::string::npos ? "" : line.substr(start);
+
+        if (line.find("#shader") != std::string::npos)
+        {
+            if (line.find("vertex") != std::string::npos)
+                context.Stage = 0;
+            else if (line.find("fragment") != std::string::npos)
+                context.Stage = 1;
+            else if (line.find("compute") != std::string::npos)
+                context.Stage = 2;
+            context.Included.clear();
+        }
+        else if (directive.compare(0, 8, "#feature") == 0)
+        {
+            std::stringstream ss(directive.substr(8));
+            std::string feature;
+            while (ss >> feature)
+                if (std::find(context.Source->Features.begin(), context.Source->Features.end(), feature) == context.Source->Features.end())
+                    context.Source->Features.push_back(feature);
+        }
+        else if (context.Stage < 0)
+        {
+            //nothing outside of a stage ends up in the program
+        }
+        else if (directive.compare(0, 8, "#include") == 0)
+        {
+            size_t open  = directive.find('"');
+            size_t close = directive.find('"', open + 1);
+            if (open == std::string::npos || close == std::string::npos)
+            {
+                std::cout << filepath << ": malformed " << directive << std::endl;
+                continue;
+            }
+
+            std::string include = GetDirectory(filepath) + directive.substr(open + 1, close - open - 1);
+            //same include twice in one stage would redeclare everything in it
+            if (!context.Included.insert(include).second)
+                continue;
+
+            if (!Append(context, include))
+                std::cout << filepath << ": can't open include " << include << std::endl;
+        }
+        else
+        {
+            context.Stages[context.Stage] << line << '\n';
+
+            //GLSL wants #version first, so defines go right behind it
+            if (directive.compare(0, 8, "#version") == 0)
+            {
+                for (const std::string& define : *context.Defines)
+                {
+                    size_t equals = define.find('=');
+                    if (equals == std::string::npos)
+                        context.Stages[context.Stage] << "#define " << define << '\n';
+                    else
+                        context.Stages[context.Stage] << "#define " << define.substr(0, equals) << ' ' << define.substr(equals + 1) << '\n';
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+std::string ShaderPreprocessor::GetDirectory(const std::string& filepath)
+{
+    size_t slash = filepath.find_last_of("/\\");
+    return slash == std::string::npos ? "" : filepath.substr(0, slash + 1);
+}
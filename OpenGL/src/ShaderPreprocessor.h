@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <sstream>
+
+#include "Shader.h"
+
+// Turns a .shader file into the sources of its stages.
+//   #shader vertex / #shader fragment	start a stage
+//   #shader compute						a compute program, no other stage may be present
+//   #include "file"						pasted in place, relative to the including file, once per stage
+//   #feature NAME						declares a keyword the file can be compiled with
+// The defines passed in are emitted right after each stage's #version line, as NAME or NAME=VALUE.
+class ShaderPreprocessor
+{
+public:
+	static ShaderProgramSource Process(const std::string& filepath, const std::vector<std::string>& defines = {});
+
+private:
+	struct Context
+	{
+		const std::vector<std::string>*	Defines;
+		ShaderProgramSource*			Source;
+		std::stringstream				Stages[3];
+		int								Stage;	  // -1 before the first #shader line
+		std::unordered_set<std::string> Included; // per stage, reset on #shader
+	};
+
+	static bool Append(Context& context, const std::string& filepath);
+	static std::string GetDirectory(const std::string& filepath);
+};
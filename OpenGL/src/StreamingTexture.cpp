@@ -0,0 +1,191 @@
+#include "StreamingTexture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "Texture.h"
+#include "stb/stb_image.h"
+
+StreamingTexture::StreamingTexture(const std::string& path, bool srgb)
+	: m_RendererID(0), m_FilePath(path), m_Width(1), m_Height(1), m_BPP(4), m_SRGB(srgb),
+	  m_LevelCount(1), m_BaseLevel(0), m_NextRow(0), m_ScreenSize(0.0f)
+{
+	//Only the header is read here, so we can allocate every level before the decode has finished
+	if (!stbi_info(path.c_str(), &m_Width, &m_Height, &m_BPP) || m_BPP < 1 || m_BPP > 4)
+	{
+		m_Width = m_Height = 1;
+		m_BPP = 4;
+	}
+
+	m_LevelCount = 1 + (int)std::floor(std::log2((float)std::max(m_Width, m_Height)));
+	//m_LevelCount means nothing real is resident yet, the last level holds a placeholder until then
+	m_BaseLevel = m_LevelCount;
+
+	GLenum internalFormat, format;
+	GLint  swizzle[4];
+	Texture::GetFormat(m_BPP, m_SRGB, internalFormat, format, swizzle);
+
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_LevelCount - 1));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, m_LevelCount - 1));
+	GLCall(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, (float)(m_LevelCount - 1)));
+
+	for (int level = 0; level < m_LevelCount; level++)
+	{
+		int width  = std::max(1, m_Width  >> level);
+		int height = std::max(1, m_Height >> level);
+		GLCall(glTexImage2D(GL_TEXTURE_2D, level, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr));
+	}
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+	UploadRows(m_LevelCount - 1, 0, 1, placeholder);
+
+	int channels = m_BPP;
+	m_Decode = std::async(std::launch::async, [path, channels]()
+	{
+		std::vector<MipLevel> mips;
+
+		//The global flip flag isnt safe to touch from a worker, the thread local one is
+		stbi_set_flip_vertically_on_load_thread(1);
+		int width, height, bpp;
+		unsigned char* buffer = stbi_load(path.c_str(), &width, &height, &bpp, channels);
+		if (!buffer)
+			return mips;
+
+		mips.push_back({ width, height, std::vector<unsigned char>(buffer, buffer + (size_t)width * height * channels) });
+		stbi_image_free(buffer);
+
+		//Box filter down to 1x1, sizes follow GL's rule of halving and rounding down
+		while (mips.back().Width > 1 || mips.back().Height > 1)
+		{
+			const MipLevel& src = mips.back();
+			MipLevel dst = { std::max(1, src.Width / 2), std::max(1, src.Height / 2), {} };
+			dst.Pixels.resize((size_t)dst.Width * dst.Height * channels);
+
+			for (int y = 0; y < dst.Height; y++)
+			{
+				int y0 = std::min(y * 2, src.Height - 1), y1 = std::min(y * 2 + 1, src.Height - 1);
+				for (int x = 0; x < dst.Width; x++)
+				{
+					int x0 = std::min(x * 2, src.Width - 1), x1 = std::min(x * 2 + 1, src.Width - 1);
+					for (int c = 0; c < channels; c++)
+					{
+						int sum = src.Pixels[((size_t)y0 * src.Width + x0) * channels + c] + src.Pixels[((size_t)y0 * src.Width + x1) * channels + c]
+								+ src.Pixels[((size_t)y1 * src.Width + x0) * channels + c] + src.Pixels[((size_t)y1 * src.Width + x1) * channels + c];
+						dst.Pixels[((size_t)y * dst.Width + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+					}
+				}
+			}
+			mips.push_back(std::move(dst));
+		}
+
+		return mips;
+	});
+}
+
+StreamingTexture::~StreamingTexture()
+{
+	if (m_Decode.valid())
+		m_Decode.wait();
+
+	GLCall(glDeleteTextures(1, &m_RendererID));
+}
+
+void StreamingTexture::Bind(unsigned int slot) const
+{
+	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+}
+
+void StreamingTexture::Unbind() const
+{
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+bool StreamingTexture::IsDecoded()
+{
+	if (m_Decode.valid() && m_Decode.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		m_Mips = m_Decode.get();
+		//The file changed size between stbi_info and the decode, the allocated chain is useless
+		if (!m_Mips.empty() && ((int)m_Mips.size() != m_LevelCount || m_Mips[0].Width != m_Width || m_Mips[0].Height != m_Height))
+			m_Mips.clear();
+	}
+
+	return !m_Mips.empty();
+}
+
+int StreamingTexture::GetDesiredLevel() const
+{
+	if (m_ScreenSize <= 0.0f)
+		return 0;
+
+	int level = (int)std::floor(std::log2(std::max(m_Width, m_Height) / m_ScreenSize));
+	return std::min(std::max(level, 0), m_LevelCount - 1);
+}
+
+size_t StreamingTexture::StreamRows(size_t budget, bool atLeastOneRow)
+{
+	int level = m_BaseLevel - 1;
+	const MipLevel& mip = m_Mips[level];
+
+	size_t rowBytes = (size_t)mip.Width * m_BPP;
+	int rows = (int)std::min<size_t>(budget / rowBytes, (size_t)(mip.Height - m_NextRow));
+	if (rows == 0 && atLeastOneRow)
+		rows = 1;
+	if (rows == 0)
+		return 0;
+
+	UploadRows(level, m_NextRow, rows, &mip.Pixels[m_NextRow * rowBytes]);
+	m_NextRow += rows;
+
+	//Only switch sampling over once the level is complete, a half uploaded level would show garbage
+	if (m_NextRow == mip.Height)
+	{
+		m_BaseLevel = level;
+		m_NextRow	= 0;
+
+		GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, m_BaseLevel));
+		GLCall(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, (float)m_BaseLevel));
+		GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+		if (m_BaseLevel == 0)
+			std::vector<MipLevel>().swap(m_Mips);
+	}
+
+	return rows * rowBytes;
+}
+
+void StreamingTexture::UploadRows(int level, int firstRow, int rowCount, const unsigned char* pixels)
+{
+	GLenum internalFormat, format;
+	GLint  swizzle[4];
+	Texture::GetFormat(m_BPP, m_SRGB, internalFormat, format, swizzle);
+
+	int width = std::max(1, m_Width >> level);
+	bool aligned = (width * m_BPP) % 4 == 0;
+
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	if (!aligned)
+	{
+		GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	}
+
+	GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, firstRow, width, rowCount, format, GL_UNSIGNED_BYTE, pixels));
+
+	if (!aligned)
+	{
+		GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	}
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <future>
+
+// Texture whose whole mip chain is allocated up front but filled from the smallest level upwards.
+// Decoding and mip generation run on a worker thread; TextureStreamer then uploads the finer levels
+// over several frames and GL_TEXTURE_BASE_LEVEL/GL_TEXTURE_MIN_LOD keep sampling on what is complete.
+class StreamingTexture
+{
+private:
+	struct MipLevel
+	{
+		int							Width, Height;
+		std::vector<unsigned char>	Pixels;
+	};
+
+	unsigned int					m_RendererID;
+	std::string						m_FilePath;
+	int								m_Width, m_Height, m_BPP;
+	bool							m_SRGB;
+	int								m_LevelCount;
+	int								m_BaseLevel;	// finest fully uploaded level
+	int								m_NextRow;		// rows of level m_BaseLevel - 1 uploaded so far
+	float							m_ScreenSize;	// longest edge on screen in pixels, drives the priority
+
+	std::future<std::vector<MipLevel>> m_Decode;
+	std::vector<MipLevel>			m_Mips;
+
+	friend class TextureStreamer;
+
+public:
+	StreamingTexture(const std::string& path, bool srgb = false);
+	~StreamingTexture();
+
+	StreamingTexture(const StreamingTexture&) = delete;
+	StreamingTexture& operator=(const StreamingTexture&) = delete;
+
+	void Bind(unsigned int slot=0) const;
+	void Unbind() const;
+
+	// Set every frame (or whenever it changes) from the projected size of whatever uses the texture
+	inline void SetScreenSize(float pixels) { m_ScreenSize = pixels; }
+
+	inline int	GetWidth()			const { return m_Width;	  }
+	inline int	GetHeight()			const { return m_Height;  }
+	inline int	GetResidentLevel()	const { return m_BaseLevel; }
+	inline bool IsFullyResident()	const { return m_BaseLevel == 0; }
+
+private:
+	bool IsDecoded();
+	int	 GetDesiredLevel() const;
+	// Uploads rows of the next finer level, returns the number of bytes it used out of the budget. With
+	// atLeastOneRow a row wider than the budget still goes up, or a small budget would stall the texture forever
+	size_t StreamRows(size_t budget, bool atLeastOneRow);
+	void   UploadRows(int level, int firstRow, int rowCount, const unsigned char* pixels);
+};
@@ -2,12 +2,13 @@
 
 #include "stb/stb_image.h"
 
-Texture::Texture(const std::string& path)
-	: m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0)
+Texture::Texture(const std::string& path, bool srgb)
+	: m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0), m_SRGB(srgb)
 {
 	//Flip texture since ogl expects texture pixels to start at bottom-left instead of top-left
 	stbi_set_flip_vertically_on_load(1);
-	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4); //4 for rgba
+	//Keep the channel count of the file, a grayscale mask stored as RGBA8 wastes 75% of its memory
+	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 0);
 
 	GLCall(glGenTextures(1, &m_RendererID));
 	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
@@ -17,7 +18,28 @@ Texture::Texture(const std::string& path)
 	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
 	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 
-	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer));
+	//failed loads leave m_BPP at 0, treat them as rgba with no data
+	if (m_BPP < 1 || m_BPP > 4)
+		m_BPP = 4;
+
+	GLenum internalFormat, format;
+	GLint  swizzle[4];
+	GetFormat(m_BPP, m_SRGB, internalFormat, format, swizzle);
+	GLCall(glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle));
+
+	//Rows are tightly packed by stb, GL assumes 4 byte aligned rows unless told otherwise
+	bool aligned = (m_Width * m_BPP) % 4 == 0;
+	if (!aligned)
+	{
+		GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	}
+
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_Width, m_Height, 0, format, GL_UNSIGNED_BYTE, m_LocalBuffer));
+
+	if (!aligned)
+	{
+		GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	}
 	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
 
 	if (m_LocalBuffer)
@@ -39,3 +61,26 @@ void Texture::Unbind() const
 {
 	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
 }
+
+void Texture::GetFormat(int channels, bool srgb, GLenum& internalFormat, GLenum& format, GLint swizzle[4])
+{
+	//Swizzle the missing channels back so shaders keep seeing rgba: gray -> (l, l, l, 1), gray+alpha -> (l, l, l, a)
+	swizzle[0] = GL_RED; swizzle[1] = GL_GREEN; swizzle[2] = GL_BLUE; swizzle[3] = GL_ALPHA;
+	switch (channels)
+	{
+		case 1:
+			internalFormat = GL_R8;	 format = GL_RED;
+			swizzle[0] = swizzle[1] = swizzle[2] = GL_RED; swizzle[3] = GL_ONE;
+			break;
+		case 2:
+			internalFormat = GL_RG8; format = GL_RG;
+			swizzle[0] = swizzle[1] = swizzle[2] = GL_RED; swizzle[3] = GL_GREEN;
+			break;
+		case 3:
+			internalFormat = srgb ? GL_SRGB8 : GL_RGB8; format = GL_RGB;
+			break;
+		default:
+			internalFormat = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8; format = GL_RGBA;
+			break;
+	}
+}
@@ -8,12 +8,14 @@ private:
 	unsigned int	m_RendererID;
 	unsigned char*	m_LocalBuffer;
 
-	int				m_Width, m_Height, m_BPP; //BPP (Bits Per Pixel)
+	int				m_Width, m_Height, m_BPP; //BPP (Bytes Per Pixel), number of channels in the source image
+	bool			m_SRGB;
 
 	std::string		m_FilePath;
 
 public:
-	Texture(const std::string& path);
+	// srgb: color data is stored gamma encoded and the sampler returns linear values
+	Texture(const std::string& path, bool srgb = false);
 	~Texture();
 
 	void Bind(unsigned int slot=0)   const;
@@ -21,5 +23,10 @@ public:
 
 	inline int GetWidth()  const { return m_Width;  }
 	inline int GetHeight() const { return m_Height; }	
+	inline int GetChannels() const { return m_BPP; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+
+	// Smallest GL format holding the given number of channels, plus the swizzle that expands it back to rgba
+	static void GetFormat(int channels, bool srgb, GLenum& internalFormat, GLenum& format, GLint swizzle[4]);
 };
 
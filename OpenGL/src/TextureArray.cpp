@@ -0,0 +1,67 @@
+#include "TextureArray.h"
+
+#include <iostream>
+
+#include "Renderer.h"
+#include "stb/stb_image.h"
+
+TextureArray::TextureArray(int width, int height, unsigned int layers)
+	: m_RendererID(0), m_Width(width), m_Height(height), m_Capacity(layers), m_Count(0)
+{
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+	//Allocate every layer up front, AddLayer only uploads into it
+	GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, m_Width, m_Height, m_Capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+TextureArray::~TextureArray()
+{
+	GLCall(glDeleteTextures(1, &m_RendererID));
+}
+
+int TextureArray::AddLayer(const std::string& path)
+{
+	int width, height, bpp;
+	//Flip for the same reason as in Texture
+	stbi_set_flip_vertically_on_load(1);
+	unsigned char* buffer = stbi_load(path.c_str(), &width, &height, &bpp, 4);
+	if (!buffer)
+		return -1;
+
+	int layer = AddLayer(buffer, width, height);
+	if (layer == -1)
+		std::cout << "Warning: " << path << " (" << width << "x" << height << ") doesn't fit texture array of " << m_Width << "x" << m_Height << std::endl;
+
+	stbi_image_free(buffer);
+	return layer;
+}
+
+int TextureArray::AddLayer(const unsigned char* rgba, int width, int height)
+{
+	if (width != m_Width || height != m_Height || m_Count == m_Capacity)
+		return -1;
+
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+	GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, m_Count, m_Width, m_Height, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+
+	return (int)m_Count++;
+}
+
+void TextureArray::Bind(unsigned int slot) const
+{
+	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+}
+
+void TextureArray::Unbind() const
+{
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+// All layers share one size and one GL_TEXTURE_2D_ARRAY, so switching image is a
+// uniform (layer index) instead of a texture bind
+class TextureArray
+{
+private:
+	unsigned int	m_RendererID;
+	int				m_Width, m_Height;
+	unsigned int	m_Capacity;
+	unsigned int	m_Count;
+
+public:
+	TextureArray(int width, int height, unsigned int layers);
+	~TextureArray();
+
+	// Returns the layer the image was stored in, or -1 if it doesnt match the array size or the array is full
+	int AddLayer(const std::string& path);
+	int AddLayer(const unsigned char* rgba, int width, int height);
+
+	void Bind(unsigned int slot=0) const;
+	void Unbind() const;
+
+	inline int			GetWidth()		const { return m_Width;	   }
+	inline int			GetHeight()		const { return m_Height;   }
+	inline unsigned int GetLayerCount() const { return m_Count;	   }
+	inline unsigned int GetCapacity()	const { return m_Capacity; }
+};
@@ -0,0 +1,198 @@
+#include "TextureAtlas.h"
+
+#include <algorithm>
+
+#include "Renderer.h"
+#include "stb/stb_image.h"
+
+// imgui_draw.cpp compiles its copy of the packer as static, so the exported one lives here
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/imstb_rectpack.h"
+
+TextureAtlas::TextureAtlas(int pageWidth, int pageHeight, int padding)
+	: m_PageWidth(pageWidth), m_PageHeight(pageHeight), m_Padding(padding)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	DeletePages();
+}
+
+int TextureAtlas::Add(const std::string& path)
+{
+	int width, height, bpp;
+	//Same orientation as Texture so UVs can be swapped between both
+	stbi_set_flip_vertically_on_load(1);
+	unsigned char* buffer = stbi_load(path.c_str(), &width, &height, &bpp, 4);
+	if (!buffer)
+		return -1;
+
+	int id = Add(path, buffer, width, height);
+	stbi_image_free(buffer);
+	return id;
+}
+
+int TextureAtlas::Add(const std::string& name, const unsigned char* rgba, int width, int height)
+{
+	if (width <= 0 || height <= 0)
+		return -1;
+	if (width + 2 * m_Padding > m_PageWidth || height + 2 * m_Padding > m_PageHeight)
+		return -1;
+
+	int id = (int)m_Images.size();
+	m_Images.push_back({ name, width, height, std::vector<unsigned char>(rgba, rgba + width * height * 4), {} });
+
+	//First fit over the existing pages, only open a new page if nothing has room left
+	for (unsigned int i = 0; i < m_Pages.size(); i++)
+		if (PackInto(*m_Pages[i], i, id))
+			return id;
+
+	Page* page = CreatePage();
+	if (PackInto(*page, (unsigned int)m_Pages.size() - 1, id))
+		return id;
+
+	m_Images.pop_back();
+	return -1;
+}
+
+void TextureAtlas::Repack()
+{
+	DeletePages();
+
+	std::vector<stbrp_rect> pending(m_Images.size());
+	for (unsigned int i = 0; i < m_Images.size(); i++)
+	{
+		pending[i].id = (int)i;
+		pending[i].w  = (stbrp_coord)(m_Images[i].Width  + 2 * m_Padding);
+		pending[i].h  = (stbrp_coord)(m_Images[i].Height + 2 * m_Padding);
+	}
+
+	//Packing everything in a single call lets stbrp sort by height, which wastes far less space
+	while (!pending.empty())
+	{
+		Page* page = CreatePage();
+		unsigned int pageIndex = (unsigned int)m_Pages.size() - 1;
+		stbrp_pack_rects(&page->Context, pending.data(), (int)pending.size());
+
+		std::vector<stbrp_rect> leftover;
+		for (const stbrp_rect& rect : pending)
+		{
+			if (!rect.was_packed)
+			{
+				leftover.push_back(rect);
+				continue;
+			}
+
+			Place(*page, pageIndex, rect);
+		}
+
+		//Every image fits an empty page (checked in Add), so this only guards against looping forever
+		ASSERT(leftover.size() < pending.size());
+		pending.swap(leftover);
+	}
+}
+
+void TextureAtlas::Bind(unsigned int page, unsigned int slot) const
+{
+	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_Pages[page]->RendererID));
+}
+
+void TextureAtlas::Unbind() const
+{
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+TextureAtlas::Page* TextureAtlas::CreatePage()
+{
+	m_Pages.push_back(std::make_unique<Page>());
+	Page* page = m_Pages.back().get();
+
+	//One node per column so the packer never has to quantize widths
+	page->Nodes.resize(m_PageWidth);
+	stbrp_init_target(&page->Context, m_PageWidth, m_PageHeight, page->Nodes.data(), (int)page->Nodes.size());
+
+	//Start fully transparent, otherwise unused space would contain whatever the driver left there
+	std::vector<unsigned char> clear((size_t)m_PageWidth * m_PageHeight * 4, 0);
+
+	GLCall(glGenTextures(1, &page->RendererID));
+	GLCall(glBindTexture(GL_TEXTURE_2D, page->RendererID));
+
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_PageWidth, m_PageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, clear.data()));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	return page;
+}
+
+void TextureAtlas::DeletePages()
+{
+	for (const auto& page : m_Pages)
+	{
+		GLCall(glDeleteTextures(1, &page->RendererID));
+	}
+	m_Pages.clear();
+}
+
+bool TextureAtlas::PackInto(Page& page, unsigned int pageIndex, int id)
+{
+	Image& image = m_Images[id];
+
+	stbrp_rect rect = {};
+	rect.id = id;
+	rect.w	= (stbrp_coord)(image.Width  + 2 * m_Padding);
+	rect.h	= (stbrp_coord)(image.Height + 2 * m_Padding);
+
+	if (!stbrp_pack_rects(&page.Context, &rect, 1))
+		return false;
+
+	Place(page, pageIndex, rect);
+	return true;
+}
+
+void TextureAtlas::Place(const Page& page, unsigned int pageIndex, const stbrp_rect& rect)
+{
+	Image& image = m_Images[rect.id];
+
+	image.Region.page	= pageIndex;
+	image.Region.x		= rect.x + m_Padding;
+	image.Region.y		= rect.y + m_Padding;
+	image.Region.width	= image.Width;
+	image.Region.height = image.Height;
+	image.Region.u0		= (float)image.Region.x / m_PageWidth;
+	image.Region.v0		= (float)image.Region.y / m_PageHeight;
+	image.Region.u1		= (float)(image.Region.x + image.Width)  / m_PageWidth;
+	image.Region.v1		= (float)(image.Region.y + image.Height) / m_PageHeight;
+	Upload(page, image);
+}
+
+// Uploads the image together with its padding. The border texels are extruded into the padding
+// so linear filtering at the region edge samples the image itself and not its neighbour.
+void TextureAtlas::Upload(const Page& page, const Image& image) const
+{
+	int paddedWidth	 = image.Width  + 2 * m_Padding;
+	int paddedHeight = image.Height + 2 * m_Padding;
+
+	std::vector<unsigned char> padded((size_t)paddedWidth * paddedHeight * 4);
+	for (int y = 0; y < paddedHeight; y++)
+	{
+		int srcY = std::min(std::max(y - m_Padding, 0), image.Height - 1);
+		for (int x = 0; x < paddedWidth; x++)
+		{
+			int srcX = std::min(std::max(x - m_Padding, 0), image.Width - 1);
+			const unsigned char* src = &image.Pixels[((size_t)srcY * image.Width + srcX) * 4];
+			unsigned char*		 dst = &padded[((size_t)y * paddedWidth + x) * 4];
+			dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3];
+		}
+	}
+
+	GLCall(glBindTexture(GL_TEXTURE_2D, page.RendererID));
+	GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, image.Region.x - m_Padding, image.Region.y - m_Padding,
+		paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, padded.data()));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "imgui/imstb_rectpack.h"
+
+// UV rectangle of a packed image, page selects which atlas texture to bind
+struct AtlasRegion
+{
+	unsigned int page;
+	int			 x, y, width, height; // texel rectangle inside the page (without padding)
+	float		 u0, v0, u1, v1;
+};
+
+class TextureAtlas
+{
+private:
+	struct Image
+	{
+		std::string					Name;
+		int							Width, Height;
+		std::vector<unsigned char>	Pixels; // RGBA8, kept so pages can be repacked
+		AtlasRegion					Region;
+	};
+
+	struct Page
+	{
+		unsigned int				RendererID;
+		stbrp_context				Context;
+		std::vector<stbrp_node>		Nodes; // must stay alive while we keep packing into this page
+	};
+
+	int									m_PageWidth, m_PageHeight;
+	int									m_Padding;
+	std::vector<Image>					m_Images;
+	std::vector<std::unique_ptr<Page>>	m_Pages; // heap allocated since stbrp_context points into itself
+
+public:
+	TextureAtlas(int pageWidth = 2048, int pageHeight = 2048, int padding = 2);
+	~TextureAtlas();
+
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	// Returns an id for GetRegion, or -1 if the image couldnt be loaded or is bigger than a page
+	int Add(const std::string& path);
+	int Add(const std::string& name, const unsigned char* rgba, int width, int height);
+
+	// Throw away all pages and pack every image again in one go (tighter than incremental packing)
+	void Repack();
+
+	void Bind(unsigned int page, unsigned int slot = 0) const;
+	void Unbind() const;
+
+	inline const AtlasRegion& GetRegion(int id) const { return m_Images[id].Region; }
+	inline unsigned int GetPageCount()  const { return (unsigned int)m_Pages.size(); }
+	inline int			GetPageWidth()  const { return m_PageWidth;  }
+	inline int			GetPageHeight() const { return m_PageHeight; }
+
+private:
+	Page* CreatePage();
+	void  DeletePages();
+	bool  PackInto(Page& page, unsigned int pageIndex, int id);
+	void  Place(const Page& page, unsigned int pageIndex, const stbrp_rect& rect);
+	void  Upload(const Page& page, const Image& image) const;
+};
@@ -0,0 +1,64 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+
+#include "StreamingTexture.h"
+
+TextureStreamer::TextureStreamer(size_t bytesPerFrame)
+	: m_Budget(bytesPerFrame), m_UploadedLastFrame(0)
+{
+}
+
+void TextureStreamer::Add(StreamingTexture& texture)
+{
+	m_Textures.push_back(&texture);
+}
+
+void TextureStreamer::Remove(StreamingTexture& texture)
+{
+	m_Textures.erase(std::remove(m_Textures.begin(), m_Textures.end(), &texture), m_Textures.end());
+}
+
+void TextureStreamer::Update()
+{
+	struct Candidate
+	{
+		StreamingTexture*	Texture;
+		float				Priority;
+	};
+
+	std::vector<Candidate> candidates;
+	for (StreamingTexture* texture : m_Textures)
+	{
+		if (texture->m_BaseLevel <= texture->GetDesiredLevel() || !texture->IsDecoded())
+			continue;
+
+		//How many screen pixels each resident texel currently covers: the blurriest texture goes first
+		int   longestEdge = std::max(texture->m_Width, texture->m_Height);
+		float screenSize  = texture->m_ScreenSize > 0.0f ? texture->m_ScreenSize : (float)longestEdge;
+		float residentEdge = (float)std::max(1, longestEdge >> std::min(texture->m_BaseLevel, texture->m_LevelCount - 1));
+		candidates.push_back({ texture, screenSize / residentEdge });
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.Priority > b.Priority; });
+
+	size_t budget = m_Budget;
+	m_UploadedLastFrame = 0;
+	for (const Candidate& candidate : candidates)
+	{
+		StreamingTexture* texture = candidate.Texture;
+		while (budget > 0 && texture->m_BaseLevel > texture->GetDesiredLevel())
+		{
+			//a frame that uploaded nothing yet always makes progress, even with a row larger than the whole budget
+			size_t used = texture->StreamRows(budget, m_UploadedLastFrame == 0);
+			if (used == 0)
+				break;
+
+			budget				-= std::min(used, budget);
+			m_UploadedLastFrame += used;
+		}
+
+		if (budget == 0)
+			break;
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+class StreamingTexture;
+
+// Spreads StreamingTexture uploads over frames: each Update uploads at most m_Budget bytes,
+// giving the bytes to the textures that are largest on screen and furthest from their desired level first
+class TextureStreamer
+{
+private:
+	size_t							m_Budget;
+	std::vector<StreamingTexture*>	m_Textures;
+	size_t							m_UploadedLastFrame;
+
+public:
+	TextureStreamer(size_t bytesPerFrame = 4 * 1024 * 1024);
+
+	void Add(StreamingTexture& texture);
+	void Remove(StreamingTexture& texture);
+
+	void Update();
+
+	inline void	  SetBudget(size_t bytesPerFrame) { m_Budget = bytesPerFrame; }
+	inline size_t GetUploadedLastFrame() const { return m_UploadedLastFrame; }
+};
@@ -0,0 +1,295 @@
+#include "TransformKernels.h"
+
+#include <cstring>
+
+#include "CpuFeatures.h"
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+typedef void (*MultiplyKernel)(const glm::mat4&, const glm::mat4*, uint32_t, unsigned char*, unsigned int);
+typedef void (*ComposeKernel)(const glm::mat4*, const glm::vec3*, const glm::quat*, const glm::vec3*, uint32_t, unsigned char*, unsigned int);
+
+// Rotation columns from a unit quaternion, scaled, with the translation as the last column. Same as
+// glm::translate * glm::mat4_cast * glm::scale without the three full matrix products.
+static inline glm::mat4 TRS(const glm::vec3& p, const glm::quat& q, const glm::vec3& s)
+{
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    glm::mat4 m;
+    m[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy + wz) * s.x, 2.0f * (xz - wy) * s.x, 0.0f);
+    m[1] = glm::vec4(2.0f * (xy - wz) * s.y, (1.0f - 2.0f * (xx + zz)) * s.y, 2.0f * (yz + wx) * s.y, 0.0f);
+    m[2] = glm::vec4(2.0f * (xz + wy) * s.z, 2.0f * (yz - wx) * s.z, (1.0f - 2.0f * (xx + yy)) * s.z, 0.0f);
+    m[3] = glm::vec4(p, 1.0f);
+    return m;
+}
+
+static void MultiplyScalar(const glm::mat4& viewProjection, const glm::mat4* models, uint32_t count, unsigned char* out, unsigned int stride)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        glm::mat4 mvp = viewProjection * models[i];
+        std::memcpy(out + (size_t)i * stride, &mvp, sizeof(glm::mat4));
+    }
+}
+
+// viewProjection is nullptr for plain TRS
+static void ComposeScalar(const glm::mat4* viewProjection, const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+    uint32_t count, unsigned char* out, unsigned int stride)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        glm::mat4 m = TRS(positions[i], rotations[i], scales[i]);
+        if (viewProjection)
+            m = *viewProjection * m;
+        std::memcpy(out + (size_t)i * stride, &m, sizeof(glm::mat4));
+    }
+}
+
+#if CPU_X86
+// SSE2 is part of every x64 CPU, so this is the baseline
+static void MultiplySSE(const glm::mat4& viewProjection, const glm::mat4* models, uint32_t count, unsigned char* out, unsigned int stride)
+{
+    __m128 a[4];
+    for (int k = 0; k < 4; k++)
+        a[k] = _mm_loadu_ps(&viewProjection[k][0]);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const float* b = &models[i][0][0];
+        float* o = (float*)(out + (size_t)i * stride);
+        for (int j = 0; j < 4; j++)
+        {
+            //column j of the product: the columns of a weighted by column j of b
+            __m128 r = _mm_mul_ps(a[0], _mm_set1_ps(b[j * 4 + 0]));
+            r = _mm_add_ps(r, _mm_mul_ps(a[1], _mm_set1_ps(b[j * 4 + 1])));
+            r = _mm_add_ps(r, _mm_mul_ps(a[2], _mm_set1_ps(b[j * 4 + 2])));
+            r = _mm_add_ps(r, _mm_mul_ps(a[3], _mm_set1_ps(b[j * 4 + 3])));
+            _mm_storeu_ps(o + j * 4, r);
+        }
+    }
+}
+
+// Four objects per iteration in structure of arrays form: every register holds one matrix element of four objects
+static void ComposeSSE(const glm::mat4* viewProjection, const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+    uint32_t count, unsigned char* out, unsigned int stride)
+{
+    const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        //quaternions are 16 bytes, a transpose turns four of them into x, y, z, w registers
+        __m128 qx = _mm_loadu_ps(&rotations[i + 0].x);
+        __m128 qy = _mm_loadu_ps(&rotations[i + 1].x);
+        __m128 qz = _mm_loadu_ps(&rotations[i + 2].x);
+        __m128 qw = _mm_loadu_ps(&rotations[i + 3].x);
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+        const glm::vec3* p = &positions[i];
+        const glm::vec3* s = &scales[i];
+        __m128 px = _mm_set_ps(p[3].x, p[2].x, p[1].x, p[0].x);
+        __m128 py = _mm_set_ps(p[3].y, p[2].y, p[1].y, p[0].y);
+        __m128 pz = _mm_set_ps(p[3].z, p[2].z, p[1].z, p[0].z);
+        __m128 sx = _mm_set_ps(s[3].x, s[2].x, s[1].x, s[0].x);
+        __m128 sy = _mm_set_ps(s[3].y, s[2].y, s[1].y, s[0].y);
+        __m128 sz = _mm_set_ps(s[3].z, s[2].z, s[1].z, s[0].z);
+
+        __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+        __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+        __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+        //m[column][row], row 3 is 0 0 0 1
+        __m128 m[4][4];
+        m[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+        m[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+        m[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+        m[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+        m[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+        m[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+        m[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+        m[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+        m[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+        m[3][0] = px;
+        m[3][1] = py;
+        m[3][2] = pz;
+        m[0][3] = m[1][3] = m[2][3] = _mm_setzero_ps();
+        m[3][3] = one;
+
+        if (viewProjection)
+        {
+            //the zeros and the one in row 3 save a quarter of the products
+            const glm::mat4& vp = *viewProjection;
+            __m128 r[4][4];
+            for (int j = 0; j < 4; j++)
+                for (int row = 0; row < 4; row++)
+                {
+                    __m128 v = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(vp[0][row]), m[j][0]),
+                        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(vp[1][row]), m[j][1]), _mm_mul_ps(_mm_set1_ps(vp[2][row]), m[j][2])));
+                    r[j][row] = j == 3 ? _mm_add_ps(v, _mm_set1_ps(vp[3][row])) : v;
+                }
+            std::memcpy(m, r, sizeof(m));
+        }
+
+        //back to one matrix per object: transposing a column's four rows gives that column of each object
+        for (int j = 0; j < 4; j++)
+        {
+            _MM_TRANSPOSE4_PS(m[j][0], m[j][1], m[j][2], m[j][3]);
+            for (int k = 0; k < 4; k++)
+                _mm_storeu_ps((float*)(out + (size_t)(i + k) * stride) + j * 4, m[j][k]);
+        }
+    }
+    ComposeScalar(viewProjection, positions + i, rotations + i, scales + i, count - i, out + (size_t)i * stride, stride);
+}
+
+// Transposes the 4x4 block in each 128 bit half on its own
+TARGET_AVX2 static inline void Transpose4x2(__m256& r0, __m256& r1, __m256& r2, __m256& r3)
+{
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t2 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+    r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+    r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+// Two columns per register, each half broadcasting its own column's elements
+TARGET_AVX2 static void MultiplyAVX2(const glm::mat4& viewProjection, const glm::mat4* models, uint32_t count, unsigned char* out, unsigned int stride)
+{
+    __m256 a[4];
+    for (int k = 0; k < 4; k++)
+        a[k] = _mm256_broadcast_ps((const __m128*)&viewProjection[k][0]);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const float* b = &models[i][0][0];
+        float* o = (float*)(out + (size_t)i * stride);
+        for (int j = 0; j < 4; j += 2)
+        {
+            __m256 columns = _mm256_loadu_ps(b + j * 4);
+            __m256 r = _mm256_mul_ps(a[0], _mm256_permute_ps(columns, 0x00));
+            r = _mm256_fmadd_ps(a[1], _mm256_permute_ps(columns, 0x55), r);
+            r = _mm256_fmadd_ps(a[2], _mm256_permute_ps(columns, 0xAA), r);
+            r = _mm256_fmadd_ps(a[3], _mm256_permute_ps(columns, 0xFF), r);
+            _mm256_storeu_ps(o + j * 4, r);
+        }
+    }
+}
+
+TARGET_AVX2 static void ComposeAVX2(const glm::mat4* viewProjection, const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+    uint32_t count, unsigned char* out, unsigned int stride)
+{
+    const __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f);
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        //quaternion k and k + 4 share a register, the transpose leaves objects 0-3 low and 4-7 high
+        const glm::quat* q = &rotations[i];
+        __m256 qx = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&q[0].x)), _mm_loadu_ps(&q[4].x), 1);
+        __m256 qy = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&q[1].x)), _mm_loadu_ps(&q[5].x), 1);
+        __m256 qz = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&q[2].x)), _mm_loadu_ps(&q[6].x), 1);
+        __m256 qw = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&q[3].x)), _mm_loadu_ps(&q[7].x), 1);
+        Transpose4x2(qx, qy, qz, qw);
+
+        const glm::vec3* p = &positions[i];
+        const glm::vec3* s = &scales[i];
+        __m256 px = _mm256_set_ps(p[7].x, p[6].x, p[5].x, p[4].x, p[3].x, p[2].x, p[1].x, p[0].x);
+        __m256 py = _mm256_set_ps(p[7].y, p[6].y, p[5].y, p[4].y, p[3].y, p[2].y, p[1].y, p[0].y);
+        __m256 pz = _mm256_set_ps(p[7].z, p[6].z, p[5].z, p[4].z, p[3].z, p[2].z, p[1].z, p[0].z);
+        __m256 sx = _mm256_set_ps(s[7].x, s[6].x, s[5].x, s[4].x, s[3].x, s[2].x, s[1].x, s[0].x);
+        __m256 sy = _mm256_set_ps(s[7].y, s[6].y, s[5].y, s[4].y, s[3].y, s[2].y, s[1].y, s[0].y);
+        __m256 sz = _mm256_set_ps(s[7].z, s[6].z, s[5].z, s[4].z, s[3].z, s[2].z, s[1].z, s[0].z);
+
+        __m256 xx = _mm256_mul_ps(qx, qx), yy = _mm256_mul_ps(qy, qy), zz = _mm256_mul_ps(qz, qz);
+        __m256 xy = _mm256_mul_ps(qx, qy), xz = _mm256_mul_ps(qx, qz), yz = _mm256_mul_ps(qy, qz);
+        __m256 wx = _mm256_mul_ps(qw, qx), wy = _mm256_mul_ps(qw, qy), wz = _mm256_mul_ps(qw, qz);
+
+        __m256 m[4][4];
+        m[0][0] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx);
+        m[0][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+        m[0][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+        m[1][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+        m[1][1] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy);
+        m[1][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+        m[2][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+        m[2][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+        m[2][2] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz);
+        m[3][0] = px;
+        m[3][1] = py;
+        m[3][2] = pz;
+        m[0][3] = m[1][3] = m[2][3] = _mm256_setzero_ps();
+        m[3][3] = one;
+
+        if (viewProjection)
+        {
+            const glm::mat4& vp = *viewProjection;
+            __m256 r[4][4];
+            for (int j = 0; j < 4; j++)
+                for (int row = 0; row < 4; row++)
+                {
+                    __m256 v = _mm256_fmadd_ps(_mm256_set1_ps(vp[0][row]), m[j][0],
+                        _mm256_fmadd_ps(_mm256_set1_ps(vp[1][row]), m[j][1], _mm256_mul_ps(_mm256_set1_ps(vp[2][row]), m[j][2])));
+                    r[j][row] = j == 3 ? _mm256_add_ps(v, _mm256_set1_ps(vp[3][row])) : v;
+                }
+            std::memcpy(m, r, sizeof(m));
+        }
+
+        for (int j = 0; j < 4; j++)
+        {
+            Transpose4x2(m[j][0], m[j][1], m[j][2], m[j][3]);
+            for (int k = 0; k < 4; k++)
+            {
+                _mm_storeu_ps((float*)(out + (size_t)(i + k) * stride) + j * 4, _mm256_castps256_ps128(m[j][k]));
+                _mm_storeu_ps((float*)(out + (size_t)(i + k + 4) * stride) + j * 4, _mm256_extractf128_ps(m[j][k], 1));
+            }
+        }
+    }
+    ComposeScalar(viewProjection, positions + i, rotations + i, scales + i, count - i, out + (size_t)i * stride, stride);
+}
+#endif
+
+static MultiplyKernel GetMultiplyKernel()
+{
+    switch (CpuFeatures::GetSimdLevel())
+    {
+#if CPU_X86
+    case SimdLevel::AVX2: return MultiplyAVX2;
+    case SimdLevel::SSE:  return MultiplySSE;
+#endif
+    default:              return MultiplyScalar;
+    }
+}
+
+static ComposeKernel GetComposeKernel()
+{
+    switch (CpuFeatures::GetSimdLevel())
+    {
+#if CPU_X86
+    case SimdLevel::AVX2: return ComposeAVX2;
+    case SimdLevel::SSE:  return ComposeSSE;
+#endif
+    default:              return ComposeScalar;
+    }
+}
+
+void TransformKernels::Multiply(const glm::mat4& viewProjection, const glm::mat4* models, uint32_t count, void* out, unsigned int stride)
+{
+    GetMultiplyKernel()(viewProjection, models, count, (unsigned char*)out, stride);
+}
+
+void TransformKernels::ComposeTRS(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, uint32_t count, void* out, unsigned int stride)
+{
+    GetComposeKernel()(nullptr, positions, rotations, scales, count, (unsigned char*)out, stride);
+}
+
+void TransformKernels::ComposeMVP(const glm::mat4& viewProjection, const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+    uint32_t count, void* out, unsigned int stride)
+{
+    GetComposeKernel()(&viewProjection, positions, rotations, scales, count, (unsigned char*)out, stride);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+// Matrix math over whole arrays of objects, 8 (AVX2) or 4 (SSE) at a time, as CpuFeatures::GetSimdLevel allows.
+// Results go to out, one mat4 every stride bytes, so they can be written straight into a mapped instance
+// buffer or a UniformRingBuffer allocation of ObjectBlocks instead of a temporary array. Inputs and outputs
+// must not overlap and out needs no particular alignment. Rotations are read as x, y, z, w, glm's default layout.
+class TransformKernels
+{
+public:
+	// out[i] = viewProjection * models[i]
+	static void Multiply(const glm::mat4& viewProjection, const glm::mat4* models, uint32_t count, void* out, unsigned int stride = sizeof(glm::mat4));
+
+	// out[i] = translate(positions[i]) * mat4_cast(rotations[i]) * scale(scales[i]), rotations must be normalized
+	static void ComposeTRS(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, uint32_t count,
+						   void* out, unsigned int stride = sizeof(glm::mat4));
+
+	// Both at once, the model matrices never leave registers: out[i] = viewProjection * TRS(i)
+	static void ComposeMVP(const glm::mat4& viewProjection, const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+						   uint32_t count, void* out, unsigned int stride = sizeof(glm::mat4));
+};
@@ -0,0 +1,35 @@
+#include "UniformBuffer.h"
+
+#include "Renderer.h"
+
+UniformBuffer::UniformBuffer(unsigned int size, const void* data) : m_Size(size)
+{
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW)); // DYNAMIC since blocks like the camera change every few frames
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+}
+
+void UniformBuffer::SetData(const void* data, unsigned int size, unsigned int offset)
+{
+    ASSERT(offset + size <= m_Size);
+
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+    GLCall(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+void UniformBuffer::BindBase(UniformBinding binding) const
+{
+    GLCall(glBindBufferBase(GL_UNIFORM_BUFFER, (unsigned int)binding, m_RendererID));
+}
+
+void UniformBuffer::BindRange(UniformBinding binding, unsigned int offset, unsigned int size) const
+{
+    GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, (unsigned int)binding, m_RendererID, offset, size));
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+// Binding points shared by every program, Shader connects blocks with these names automatically
+enum class UniformBinding : unsigned int
+{
+	Camera = 0, Object = 1, Material = 2, Culling = 3
+};
+
+// std140 compatible as is: only mat4/vec4 members
+struct CameraBlock
+{
+	glm::mat4 ViewProjection;
+	glm::mat4 View;
+	glm::mat4 Projection;
+};
+
+struct ObjectBlock
+{
+	glm::mat4 Model;
+	glm::vec4 Color;
+};
+
+// Input of the culling compute shader, see GPUCulling
+struct CullingBlock
+{
+	glm::vec4	 Planes[6];
+	unsigned int ObjectCount;
+	unsigned int Padding[3];
+};
+
+class UniformBuffer
+{
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Size;
+
+public:
+	UniformBuffer(unsigned int size, const void* data = nullptr);
+	~UniformBuffer();
+
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+
+	void BindBase(UniformBinding binding) const;
+	void BindRange(UniformBinding binding, unsigned int offset, unsigned int size) const;
+
+	inline unsigned int GetSize() const { return m_Size; }
+};
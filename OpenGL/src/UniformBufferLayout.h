@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <GL/glew.h>
+
+#include "glm/glm.hpp"
+
+// Offsets of the members of a std140 uniform block, in declaration order
+struct UniformBufferElement
+{
+	unsigned int type;
+	unsigned int count;
+	unsigned int offset;
+	unsigned int stride; // distance between array elements, 0 for single values
+};
+
+// Computes std140 offsets the same way VertexBufferLayout computes vertex strides:
+// Push the members in the order the block declares them and use the returned offsets to write the data.
+//   scalars align to 4, vec2 to 8, vec3/vec4/mat4 to 16, array elements are padded to 16
+class UniformBufferLayout
+{
+private:
+	unsigned int m_Size;
+	std::vector<UniformBufferElement> m_Elements;
+
+public:
+	UniformBufferLayout() : m_Size(0) {}
+
+	template<typename T>
+	unsigned int Push(unsigned int count = 1);
+
+	inline const std::vector<UniformBufferElement>& GetElements() const { return m_Elements; }
+	// The size of a block is rounded up to the alignment of a vec4
+	inline unsigned int GetSize() const { return (m_Size + 15) & ~15u; }
+
+private:
+	unsigned int Add(unsigned int type, unsigned int count, unsigned int size, unsigned int alignment)
+	{
+		unsigned int stride = 0;
+		if (count > 1)
+		{
+			//std140 rounds the alignment and stride of every array element up to a vec4
+			alignment = 16;
+			stride	  = (size + 15) & ~15u;
+		}
+
+		unsigned int offset = (m_Size + alignment - 1) & ~(alignment - 1);
+		m_Elements.push_back({ type, count, offset, stride });
+		m_Size = offset + (count > 1 ? stride * count : size);
+		return offset;
+	}
+};
+
+template<>
+inline unsigned int UniformBufferLayout::Push<float>(unsigned int count)		{ return Add(GL_FLOAT, count, 4, 4); }
+
+template<>
+inline unsigned int UniformBufferLayout::Push<int>(unsigned int count)			{ return Add(GL_INT, count, 4, 4); }
+
+template<>
+inline unsigned int UniformBufferLayout::Push<unsigned int>(unsigned int count) { return Add(GL_UNSIGNED_INT, count, 4, 4); }
+
+template<>
+inline unsigned int UniformBufferLayout::Push<glm::vec2>(unsigned int count)	{ return Add(GL_FLOAT_VEC2, count, 8, 8); }
+
+template<>
+inline unsigned int UniformBufferLayout::Push<glm::vec3>(unsigned int count)	{ return Add(GL_FLOAT_VEC3, count, 12, 16); }
+
+template<>
+inline unsigned int UniformBufferLayout::Push<glm::vec4>(unsigned int count)	{ return Add(GL_FLOAT_VEC4, count, 16, 16); }
+
+template<>
+inline unsigned int UniformBufferLayout::Push<glm::mat4>(unsigned int count)	{ return Add(GL_FLOAT_MAT4, count, 64, 16); }
@@ -0,0 +1,102 @@
+#include "UniformRingBuffer.h"
+
+#include <cstring>
+
+#include "Renderer.h"
+
+UniformRingBuffer::UniformRingBuffer(unsigned int bytesPerFrame, unsigned int framesInFlight)
+    : m_RendererID(0), m_SegmentSize(0), m_Alignment(256), m_Segment(0), m_Head(0), m_Flushed(0), m_Fences(framesInFlight, nullptr)
+{
+    int alignment;
+    GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    m_Alignment = alignment > 0 ? (unsigned int)alignment : 256;
+
+    m_SegmentSize = (bytesPerFrame + m_Alignment - 1) / m_Alignment * m_Alignment;
+    m_Staging.resize(m_SegmentSize);
+
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, m_SegmentSize * framesInFlight, nullptr, GL_STREAM_DRAW));
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+UniformRingBuffer::~UniformRingBuffer()
+{
+    for (GLsync fence : m_Fences)
+    {
+        if (fence)
+        {
+            GLCall(glDeleteSync(fence));
+        }
+    }
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+}
+
+void UniformRingBuffer::BeginFrame()
+{
+    m_Segment = (m_Segment + 1) % m_Fences.size();
+    m_Head	  = 0;
+    m_Flushed = 0;
+
+    //Only blocks if the GPU is still framesInFlight frames behind
+    GLsync& fence = m_Fences[m_Segment];
+    if (fence)
+    {
+        GLCall(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED));
+        GLCall(glDeleteSync(fence));
+        fence = nullptr;
+    }
+}
+
+void UniformRingBuffer::EndFrame()
+{
+    Flush();
+    GLCall(m_Fences[m_Segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+unsigned int UniformRingBuffer::Allocate(const void* data, unsigned int size)
+{
+    unsigned int offset = (m_Head + m_Alignment - 1) / m_Alignment * m_Alignment;
+    ASSERT(offset + size <= m_SegmentSize);
+
+    memcpy(&m_Staging[offset], data, size);
+    m_Head = offset + size;
+
+    return m_Segment * m_SegmentSize + offset;
+}
+
+unsigned int UniformRingBuffer::Allocate(unsigned int size, unsigned int count, unsigned char*& data)
+{
+    unsigned int offset = (m_Head + m_Alignment - 1) / m_Alignment * m_Alignment;
+    unsigned int stride = GetStride(size);
+    ASSERT(count > 0 && offset + stride * (count - 1) + size <= m_SegmentSize);
+
+    data = &m_Staging[offset];
+    m_Head = offset + stride * (count - 1) + size;
+
+    return m_Segment * m_SegmentSize + offset;
+}
+
+void UniformRingBuffer::Flush()
+{
+    if (m_Head == m_Flushed)
+        return;
+
+    //The fence in BeginFrame already made sure the GPU is done with this segment, so no need for the driver to sync
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+    GLCall(void* dst = glMapBufferRange(GL_UNIFORM_BUFFER, m_Segment * m_SegmentSize + m_Flushed, m_Head - m_Flushed,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    if (dst)
+    {
+        memcpy(dst, &m_Staging[m_Flushed], m_Head - m_Flushed);
+        GLCall(glUnmapBuffer(GL_UNIFORM_BUFFER));
+    }
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+
+    m_Flushed = m_Head;
+}
+
+void UniformRingBuffer::BindRange(UniformBinding binding, unsigned int offset, unsigned int size) const
+{
+    GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, (unsigned int)binding, m_RendererID, offset, size));
+}
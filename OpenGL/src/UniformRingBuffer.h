@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <GL/glew.h>
+
+#include "UniformBuffer.h"
+
+// Per-object uniform blocks for a whole frame in one buffer. Blocks are appended to a CPU staging area,
+// uploaded together by Flush and selected per draw with glBindBufferRange. The buffer is split into one
+// segment per frame in flight and a fence guards each segment, so we never write memory the GPU still reads.
+class UniformRingBuffer
+{
+private:
+	unsigned int				m_RendererID;
+	unsigned int				m_SegmentSize;
+	unsigned int				m_Alignment; // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	unsigned int				m_Segment;
+	unsigned int				m_Head;		 // bytes staged in the current segment
+	unsigned int				m_Flushed;	 // bytes already uploaded
+	std::vector<unsigned char>	m_Staging;
+	std::vector<GLsync>			m_Fences;
+
+public:
+	UniformRingBuffer(unsigned int bytesPerFrame, unsigned int framesInFlight = 3);
+	~UniformRingBuffer();
+
+	UniformRingBuffer(const UniformRingBuffer&) = delete;
+	UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+	void BeginFrame();
+	void EndFrame();
+
+	// Returns the offset to pass to BindRange
+	unsigned int Allocate(const void* data, unsigned int size);
+	// Reserves count blocks to be written in place, e.g. by TransformKernels. Block i starts at data + i * GetStride(size),
+	// its offset is the returned one plus as much. Write before the next Flush.
+	unsigned int Allocate(unsigned int size, unsigned int count, unsigned char*& data);
+	inline unsigned int GetStride(unsigned int size) const { return (size + m_Alignment - 1) / m_Alignment * m_Alignment; }
+	// Uploads everything allocated since the last Flush, call before the draws that use it
+	void Flush();
+
+	void BindRange(UniformBinding binding, unsigned int offset, unsigned int size) const;
+};
@@ -2,8 +2,10 @@
 
 #include "VertexBufferLayout.h"
 #include "Renderer.h"
+#include "Shader.h"
 
 VertexArray::VertexArray()
+    : m_LayoutHash(0)
 {
     GLCall(glGenVertexArrays(1, &m_RendererID));
 }
@@ -14,6 +16,20 @@ VertexArray::~VertexArray()
 }
 
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+{
+    std::vector<int> locations(layout.GetElements().size());
+    for (unsigned int i = 0; i < locations.size(); i++)
+        locations[i] = i;
+
+    AddBuffer(vb, layout, locations);
+}
+
+void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, const Shader& shader)
+{
+    AddBuffer(vb, layout, shader.GetAttributeLocations(layout));
+}
+
+void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, const std::vector<int>& locations)
 {
     Bind();
 
@@ -25,13 +41,23 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
     {
         const auto& element = elements[i];
 
-        //enable first vertex attrib array
-        GLCall(glEnableVertexAttribArray(i));
+        //elements the shader doesn't read are skipped, their bytes still count towards the offset
+        if (locations[i] != -1)
+        {
+            //enable vertex attrib array at the location the shader reads from
+            GLCall(glEnableVertexAttribArray(locations[i]));
 
-        // first attribute index 0, num elements in vertex, type of vertex data, already normalized (no need for it),  stride (only pos so 8 bytes), only one attribute so pointer offset is 0
-        GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), (const void*) offset));
+            // attribute location, num elements in vertex, type of vertex data, already normalized (no need for it), stride, offset of this element in the vertex
+            GLCall(glVertexAttribPointer(locations[i], element.count, element.type, element.normalized, layout.GetStride(), (const void*) offset));
+        }
         offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
     }
+
+    m_LayoutHash = layout.GetHash();
+    m_AttributeNames.clear();
+    for (const auto& element : elements)
+        m_AttributeNames.push_back(element.name);
+    m_Locations = locations;
 }
 
 void VertexArray::Bind() const
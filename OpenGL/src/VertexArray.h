@@ -1,20 +1,41 @@
 #pragma once
 
+#include <vector>
+#include <string>
+#include <cstdint>
+
 #include "VertexBuffer.h"
 
 class VertexBufferLayout;
+class Shader;
 
 class VertexArray
 {
 private:
 	unsigned int m_RendererID;
+	// what the attributes were specified with, lets a shader check it can draw this VAO
+	uint64_t				 m_LayoutHash;
+	std::vector<std::string> m_AttributeNames;
+	std::vector<int>		 m_Locations;
 
 public:
 	VertexArray();
 	~VertexArray();
 
+	// Element i goes to attribute location i
 	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	// Elements go to the locations of the shader's attributes with the same names.
+	// Any program agreeing on those locations can draw the VAO without specifying it again.
+	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, const Shader& shader);
+
+	inline uint64_t GetLayoutHash() const { return m_LayoutHash; }
+	inline const std::vector<std::string>& GetAttributeNames() const { return m_AttributeNames; }
+	inline const std::vector<int>& GetLocations() const { return m_Locations; }
+
 	void Bind()   const;
 	void Unbind() const;
+
+private:
+	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, const std::vector<int>& locations);
 };
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <string>
+#include <cstdint>
 #include <GL/glew.h>
 
 #include "Renderer.h"
@@ -10,6 +12,7 @@ struct VertexBufferElement
 	unsigned int  type;
 	unsigned int  count;
 	unsigned char normalized;
+	std::string   name; // matched against the shader's attribute names, empty to go by position
 
 	static unsigned int GetSizeOfType(unsigned int type)
 	{
@@ -30,38 +33,60 @@ class VertexBufferLayout
 private:
 	unsigned int m_Stride;
 	std::vector<VertexBufferElement> m_Elements;
+	uint64_t	 m_Hash; // of the element names, types and order, identifies the layout to Shader's attribute mapping
 
 public:
-	VertexBufferLayout() : m_Stride(0) {}
+	VertexBufferLayout() : m_Stride(0), m_Hash(14695981039346656037ull) {}
 
+	// name is the semantic, e.g. Push<float>(2, "position") feeds "in vec4 position" whatever its location
 	template<typename T>
-	void Push(unsigned int count)
+	void Push(unsigned int count, const std::string& name = std::string())
 	{
 		static_assert(false);
 	}
 
 	template<>
-	void Push<float>(unsigned int count) 
+	void Push<float>(unsigned int count, const std::string& name) 
 	{
-		m_Elements.push_back({ GL_FLOAT, count, GL_FALSE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_FLOAT);
+		Add({ GL_FLOAT, count, GL_FALSE, name });
 	}
 
 	template<>
-	void Push<unsigned int>(unsigned int count)
+	void Push<unsigned int>(unsigned int count, const std::string& name)
 	{
-		m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT);
+		Add({ GL_UNSIGNED_INT, count, GL_FALSE, name });
 	}
 
 	template<>
-	void Push<unsigned char>(unsigned int count)
+	void Push<unsigned char>(unsigned int count, const std::string& name)
 	{
-		m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
-		m_Stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE);
+		Add({ GL_UNSIGNED_BYTE, count, GL_TRUE, name });
 	}
 
 	inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
 	inline unsigned int GetStride() const { return m_Stride; }
+	inline uint64_t GetHash() const { return m_Hash; }
+
+private:
+	void Add(const VertexBufferElement& element)
+	{
+		m_Elements.push_back(element);
+		m_Stride += element.count * VertexBufferElement::GetSizeOfType(element.type);
+
+		//FNV-1a, the name's terminator keeps "ab"+"c" apart from "a"+"bc"
+		unsigned int fields[3] = { element.type, element.count, element.normalized };
+		Mix(fields, sizeof(fields));
+		Mix(element.name.c_str(), element.name.size() + 1);
+	}
+
+	void Mix(const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			m_Hash ^= bytes[i];
+			m_Hash *= 1099511628211ull;
+		}
+	}
 };
 
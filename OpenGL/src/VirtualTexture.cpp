@@ -0,0 +1,450 @@
+#include "VirtualTexture.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "Renderer.h"
+#include "Shader.h"
+#include "stb/stb_image.h"
+
+static const unsigned int s_EmptySlot = 0xFFFFFFFF;
+
+VirtualTexture::VirtualTexture(const std::string& path, int tileSize, int cacheSide, int feedbackDivisor)
+	: m_TileSize(tileSize), m_Border(1), m_TilesPerSide(1), m_MaxMip(0), m_CacheSide(cacheSide), m_ScaleX(1.0f), m_ScaleY(1.0f),
+	  m_PageTableID(0), m_CacheID(0), m_PageTableDirty(true), m_Frame(0),
+	  m_FeedbackFBO(0), m_FeedbackColor(0), m_FeedbackDepth(0), m_FeedbackPBO{ 0, 0 }, m_FeedbackWidth(0), m_FeedbackHeight(0),
+	  m_FeedbackDivisor(feedbackDivisor), m_FeedbackIndex(0), m_FeedbackFence{ nullptr, nullptr }, m_Viewport{ 0, 0, 0, 0 },
+	  m_PreviousDrawFBO(0), m_PreviousReadFBO(0), m_PreviousClearColor{ 0.0f, 0.0f, 0.0f, 0.0f },
+	  m_Running(true)
+{
+	//The decoded image only lives in system memory, VRAM just holds the tile cache
+	int width = 0, height = 0, bpp = 0;
+	stbi_set_flip_vertically_on_load(1);
+	unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &bpp, 4);
+	if (!pixels)
+	{
+		std::cout << "Failed to load virtual texture " << path << std::endl;
+		width = height = 1;
+		pixels = (unsigned char*)calloc(4, 1);
+	}
+
+	//Tile coordinates are written to an RGBA8 feedback target, so 256 tiles per side is the limit
+	int tilesX = (width	 + m_TileSize - 1) / m_TileSize;
+	int tilesY = (height + m_TileSize - 1) / m_TileSize;
+	while (m_TilesPerSide < std::max(tilesX, tilesY))
+	{
+		m_TilesPerSide *= 2;
+		m_MaxMip++;
+	}
+	ASSERT(m_TilesPerSide <= 256 && m_CacheSide <= 256);
+	//Slot 0 is pinned to the coarsest mip, eviction needs at least one more
+	ASSERT(m_CacheSide >= 2);
+
+	m_ScaleX = (float)width	 / (m_TilesPerSide * m_TileSize);
+	m_ScaleY = (float)height / (m_TilesPerSide * m_TileSize);
+
+	BuildMips(pixels, width, height);
+	stbi_image_free(pixels);
+
+	//Page table: one texel per tile, with the same mip chain as the virtual texture
+	GLCall(glGenTextures(1, &m_PageTableID));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_PageTableID));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_MaxMip));
+	m_PageTable.resize(m_MaxMip + 1);
+	for (int mip = 0; mip <= m_MaxMip; mip++)
+	{
+		int side = m_TilesPerSide >> mip;
+		m_PageTable[mip].assign(side * side, 0);
+		GLCall(glTexImage2D(GL_TEXTURE_2D, mip, GL_RGBA8, side, side, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	}
+
+	//Physical cache: every slot holds one tile plus its border so bilinear filtering doesnt bleed
+	int slotSize = m_TileSize + 2 * m_Border;
+	GLCall(glGenTextures(1, &m_CacheID));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_CacheID));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_CacheSide * slotSize, m_CacheSide * slotSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	m_Slots.assign(m_CacheSide * m_CacheSide, { s_EmptySlot, 0 });
+
+	GLCall(glGenBuffers(2, m_FeedbackPBO));
+
+	m_Loader = std::thread(&VirtualTexture::LoaderThread, this);
+
+	//The single tile of the last mip is pinned in slot 0, so every lookup has something to fall back to
+	LoadedTile root = { MakeKey(0, 0, m_MaxMip), {} };
+	ExtractTile(root.Key, root.Pixels);
+	UploadTile(root);
+	RebuildPageTable();
+}
+
+VirtualTexture::~VirtualTexture()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Running = false;
+	}
+	m_Condition.notify_all();
+	m_Loader.join();
+
+	DeleteFeedbackTarget();
+	for (GLsync fence : m_FeedbackFence)
+	{
+		if (fence)
+		{
+			GLCall(glDeleteSync(fence));
+		}
+	}
+	GLCall(glDeleteBuffers(2, m_FeedbackPBO));
+	GLCall(glDeleteTextures(1, &m_PageTableID));
+	GLCall(glDeleteTextures(1, &m_CacheID));
+}
+
+void VirtualTexture::BeginFeedback(int viewportWidth, int viewportHeight)
+{
+	//everything the feedback pass changes goes back to what the caller had in EndFeedback
+	GLCall(glGetIntegerv(GL_VIEWPORT, m_Viewport));
+	GLCall(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_PreviousDrawFBO));
+	GLCall(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &m_PreviousReadFBO));
+	GLCall(glGetFloatv(GL_COLOR_CLEAR_VALUE, m_PreviousClearColor));
+
+	int width  = std::max(1, viewportWidth  / m_FeedbackDivisor);
+	int height = std::max(1, viewportHeight / m_FeedbackDivisor);
+	if (width != m_FeedbackWidth || height != m_FeedbackHeight)
+		CreateFeedbackTarget(width, height);
+
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_FeedbackFBO));
+	GLCall(glViewport(0, 0, m_FeedbackWidth, m_FeedbackHeight));
+
+	//Alpha 0 marks pixels that didnt request anything
+	GLCall(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+	GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+}
+
+void VirtualTexture::EndFeedback()
+{
+	//Consume the readbacks the GPU has finished, oldest first. A zero timeout only asks, so mapping never waits;
+	//the flush bit makes sure the fence reaches the GPU at all
+	for (int i = 1; i <= 2; i++)
+	{
+		int slot = (m_FeedbackIndex + i) % 2;
+		if (!m_FeedbackFence[slot])
+			continue;
+
+		GLCall(GLenum status = glClientWaitSync(m_FeedbackFence[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+
+		GLCall(glDeleteSync(m_FeedbackFence[slot]));
+		m_FeedbackFence[slot] = nullptr;
+
+		GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_FeedbackPBO[slot]));
+		GLCall(const unsigned char* pixels = (const unsigned char*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+		if (pixels)
+		{
+			ProcessFeedback(pixels);
+			GLCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+		}
+	}
+
+	//Kick off an asynchronous read of this frame. If the GPU is so far behind that both PBOs are still in flight,
+	//this frame's feedback is skipped rather than waited for
+	if (!m_FeedbackFence[m_FeedbackIndex])
+	{
+		GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_FeedbackPBO[m_FeedbackIndex]));
+		GLCall(glReadPixels(0, 0, m_FeedbackWidth, m_FeedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+		GLCall(m_FeedbackFence[m_FeedbackIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+		m_FeedbackIndex = 1 - m_FeedbackIndex;
+	}
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+	GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_PreviousDrawFBO));
+	GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_PreviousReadFBO));
+	GLCall(glViewport(m_Viewport[0], m_Viewport[1], m_Viewport[2], m_Viewport[3]));
+	GLCall(glClearColor(m_PreviousClearColor[0], m_PreviousClearColor[1], m_PreviousClearColor[2], m_PreviousClearColor[3]));
+}
+
+void VirtualTexture::Update(unsigned int maxUploads)
+{
+	std::deque<LoadedTile> loaded;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		while (!m_Loaded.empty() && loaded.size() < maxUploads)
+		{
+			loaded.push_back(std::move(m_Loaded.front()));
+			m_Loaded.pop_front();
+		}
+	}
+
+	for (const LoadedTile& tile : loaded)
+	{
+		m_Pending.erase(tile.Key);
+		UploadTile(tile);
+	}
+
+	if (m_PageTableDirty)
+		RebuildPageTable();
+
+	m_Frame++;
+}
+
+void VirtualTexture::Bind(unsigned int pageTableSlot, unsigned int cacheSlot) const
+{
+	GLCall(glActiveTexture(GL_TEXTURE0 + pageTableSlot));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_PageTableID));
+	GLCall(glActiveTexture(GL_TEXTURE0 + cacheSlot));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_CacheID));
+}
+
+void VirtualTexture::SetUniforms(Shader& shader, unsigned int pageTableSlot, unsigned int cacheSlot) const
+{
+	shader.SetUniform1i("u_PageTable", pageTableSlot);
+	shader.SetUniform1i("u_Cache", cacheSlot);
+	shader.SetUniform4f("u_VTParams", (float)m_TilesPerSide, (float)m_MaxMip, (float)m_CacheSide, (float)m_TileSize);
+	//w is the mip bias of the feedback pass, its derivatives are m_FeedbackDivisor times larger
+	shader.SetUniform4f("u_VTScale", m_ScaleX, m_ScaleY, (float)m_Border, std::log2((float)m_FeedbackDivisor));
+}
+
+// Box filtered mip chain down to the level where the whole image fits in one tile
+void VirtualTexture::BuildMips(unsigned char* pixels, int width, int height)
+{
+	m_Mips.resize(m_MaxMip + 1);
+	m_Mips[0] = { width, height, std::vector<unsigned char>(pixels, pixels + (size_t)width * height * 4) };
+
+	for (int mip = 1; mip <= m_MaxMip; mip++)
+	{
+		const MipImage& src = m_Mips[mip - 1];
+		MipImage& dst = m_Mips[mip];
+		dst.Width  = std::max(1, src.Width	/ 2);
+		dst.Height = std::max(1, src.Height / 2);
+		dst.Pixels.resize((size_t)dst.Width * dst.Height * 4);
+
+		for (int y = 0; y < dst.Height; y++)
+		{
+			int y0 = std::min(y * 2, src.Height - 1), y1 = std::min(y * 2 + 1, src.Height - 1);
+			for (int x = 0; x < dst.Width; x++)
+			{
+				int x0 = std::min(x * 2, src.Width - 1), x1 = std::min(x * 2 + 1, src.Width - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					int sum = src.Pixels[((size_t)y0 * src.Width + x0) * 4 + c] + src.Pixels[((size_t)y0 * src.Width + x1) * 4 + c]
+							+ src.Pixels[((size_t)y1 * src.Width + x0) * 4 + c] + src.Pixels[((size_t)y1 * src.Width + x1) * 4 + c];
+					dst.Pixels[((size_t)y * dst.Width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+void VirtualTexture::CreateFeedbackTarget(int width, int height)
+{
+	DeleteFeedbackTarget();
+	m_FeedbackWidth	 = width;
+	m_FeedbackHeight = height;
+
+	GLCall(glGenTextures(1, &m_FeedbackColor));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_FeedbackColor));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	GLCall(glGenRenderbuffers(1, &m_FeedbackDepth));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_FeedbackDepth));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+	GLCall(glGenFramebuffers(1, &m_FeedbackFBO));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_FeedbackFBO));
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_FeedbackColor, 0));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_FeedbackDepth));
+	GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	ASSERT(status == GL_FRAMEBUFFER_COMPLETE);
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+
+	for (int i = 0; i < 2; i++)
+	{
+		GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_FeedbackPBO[i]));
+		GLCall(glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, nullptr, GL_STREAM_READ));
+		//reads of the old size are no use anymore
+		if (m_FeedbackFence[i])
+		{
+			GLCall(glDeleteSync(m_FeedbackFence[i]));
+			m_FeedbackFence[i] = nullptr;
+		}
+	}
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+}
+
+void VirtualTexture::DeleteFeedbackTarget()
+{
+	if (!m_FeedbackFBO)
+		return;
+
+	GLCall(glDeleteFramebuffers(1, &m_FeedbackFBO));
+	GLCall(glDeleteRenderbuffers(1, &m_FeedbackDepth));
+	GLCall(glDeleteTextures(1, &m_FeedbackColor));
+	m_FeedbackFBO = m_FeedbackDepth = m_FeedbackColor = 0;
+}
+
+void VirtualTexture::ProcessFeedback(const unsigned char* pixels)
+{
+	//Neighbouring pixels mostly request the same tile, dedupe before touching the cache
+	std::unordered_set<unsigned int> requested;
+	for (int i = 0; i < m_FeedbackWidth * m_FeedbackHeight; i++)
+	{
+		const unsigned char* p = pixels + i * 4;
+		if (p[3] == 0)
+			continue;
+		requested.insert(MakeKey(p[0], p[1], std::min((int)p[2], m_MaxMip)));
+	}
+
+	//Coarse tiles first: they cover more screen and are what the finer ones fall back to
+	std::vector<unsigned int> sorted(requested.begin(), requested.end());
+	std::sort(sorted.begin(), sorted.end(), [](unsigned int a, unsigned int b) { return (a >> 16) > (b >> 16); });
+
+	for (unsigned int key : sorted)
+		RequestTile(key);
+}
+
+void VirtualTexture::RequestTile(unsigned int key)
+{
+	auto it = m_Resident.find(key);
+	if (it != m_Resident.end())
+	{
+		m_Slots[it->second].LastUsed = m_Frame;
+		return;
+	}
+
+	if (!m_Pending.insert(key).second)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Requests.push_back(key);
+	}
+	m_Condition.notify_one();
+}
+
+void VirtualTexture::UploadTile(const LoadedTile& tile)
+{
+	//Free slot if there is one, otherwise evict the least recently requested tile (slot 0 is pinned)
+	unsigned int slot = 0;
+	if (!m_Resident.empty())
+	{
+		slot = 1;
+		for (unsigned int i = 1; i < m_Slots.size(); i++)
+		{
+			if (m_Slots[i].Key == s_EmptySlot)
+			{
+				slot = i;
+				break;
+			}
+			if (m_Slots[i].LastUsed < m_Slots[slot].LastUsed)
+				slot = i;
+		}
+	}
+
+	if (m_Slots[slot].Key != s_EmptySlot)
+		m_Resident.erase(m_Slots[slot].Key);
+
+	m_Slots[slot] = { tile.Key, m_Frame };
+	m_Resident[tile.Key] = slot;
+
+	int slotSize = m_TileSize + 2 * m_Border;
+	int x = (slot % m_CacheSide) * slotSize;
+	int y = (slot / m_CacheSide) * slotSize;
+
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_CacheID));
+	GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, slotSize, slotSize, GL_RGBA, GL_UNSIGNED_BYTE, tile.Pixels.data()));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	m_PageTableDirty = true;
+}
+
+// Every page table entry points at the finest resident tile covering it: either the tile itself or,
+// walking from the coarsest mip down, whatever its parent entry already points at.
+// Entry layout (RGBA8): cache slot x, cache slot y, mip of the resident tile, 255
+void VirtualTexture::RebuildPageTable()
+{
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_PageTableID));
+	for (int mip = m_MaxMip; mip >= 0; mip--)
+	{
+		int side = m_TilesPerSide >> mip;
+		std::vector<unsigned int>& entries = m_PageTable[mip];
+		for (int y = 0; y < side; y++)
+		{
+			for (int x = 0; x < side; x++)
+			{
+				auto it = m_Resident.find(MakeKey(x, y, mip));
+				if (it != m_Resident.end())
+				{
+					unsigned int slot = it->second;
+					entries[y * side + x] = (slot % m_CacheSide) | (slot / m_CacheSide) << 8 | (unsigned int)mip << 16 | 0xFF000000;
+				}
+				else
+				{
+					int parentSide = side / 2;
+					entries[y * side + x] = m_PageTable[mip + 1][(y / 2) * parentSide + x / 2];
+				}
+			}
+		}
+		GLCall(glTexSubImage2D(GL_TEXTURE_2D, mip, 0, 0, side, side, GL_RGBA, GL_UNSIGNED_BYTE, entries.data()));
+	}
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	m_PageTableDirty = false;
+}
+
+void VirtualTexture::LoaderThread()
+{
+	while (true)
+	{
+		unsigned int key;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this] { return !m_Running || !m_Requests.empty(); });
+			if (!m_Running)
+				return;
+
+			key = m_Requests.front();
+			m_Requests.pop_front();
+		}
+
+		//Mip images are never modified after construction, so reading them here needs no lock
+		LoadedTile tile = { key, {} };
+		ExtractTile(key, tile.Pixels);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Loaded.push_back(std::move(tile));
+	}
+}
+
+// Copies one tile and its border out of the mip chain, clamping at the image edges
+void VirtualTexture::ExtractTile(unsigned int key, std::vector<unsigned char>& out) const
+{
+	int tx = key & 0xFF, ty = (key >> 8) & 0xFF, mip = key >> 16;
+	const MipImage& image = m_Mips[mip];
+
+	int slotSize = m_TileSize + 2 * m_Border;
+	out.resize((size_t)slotSize * slotSize * 4);
+
+	for (int y = 0; y < slotSize; y++)
+	{
+		int srcY = std::min(std::max(ty * m_TileSize + y - m_Border, 0), image.Height - 1);
+		for (int x = 0; x < slotSize; x++)
+		{
+			int srcX = std::min(std::max(tx * m_TileSize + x - m_Border, 0), image.Width - 1);
+			const unsigned char* src = &image.Pixels[((size_t)srcY * image.Width + srcX) * 4];
+			std::copy(src, src + 4, &out[((size_t)y * slotSize + x) * 4]);
+		}
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <GL/glew.h>
+
+class Shader;
+
+// Sparse texture for images far bigger than we want resident in VRAM. The image is cut into
+// square tiles per mip level; only the tiles the feedback pass saw on screen are streamed into
+// a fixed size cache texture, and a page table texture tells the shader where each tile lives.
+// Memory use therefore depends on the cache size (screen coverage), not on the image size.
+//
+// Per frame:
+//   vt.BeginFeedback(w, h);  draw the scene with VirtualTextureFeedback.shader;  vt.EndFeedback();
+//   vt.Update();             then draw normally with VirtualTexture.shader
+class VirtualTexture
+{
+private:
+	struct MipImage
+	{
+		int							Width, Height;
+		std::vector<unsigned char>	Pixels; // RGBA8
+	};
+
+	struct LoadedTile
+	{
+		unsigned int				Key;
+		std::vector<unsigned char>	Pixels;
+	};
+
+	struct CacheSlot
+	{
+		unsigned int Key;	   // tile stored in this slot, s_EmptySlot if none
+		unsigned int LastUsed; // frame it was last requested by the feedback pass, for LRU replacement
+	};
+
+	int								m_TileSize;
+	int								m_Border;
+	int								m_TilesPerSide;	// mip 0, padded to a power of two
+	int								m_MaxMip;
+	int								m_CacheSide;	// cache holds m_CacheSide^2 tiles
+	float							m_ScaleX, m_ScaleY; // image uv -> virtual uv
+
+	std::vector<MipImage>			m_Mips;
+
+	unsigned int					m_PageTableID;
+	unsigned int					m_CacheID;
+	std::vector<std::vector<unsigned int>> m_PageTable; // CPU copy, one RGBA8 entry per tile per mip
+	bool							m_PageTableDirty;
+
+	std::vector<CacheSlot>			m_Slots;
+	std::unordered_map<unsigned int, unsigned int> m_Resident; // tile key -> slot
+	std::unordered_set<unsigned int> m_Pending; // requested, not uploaded yet
+	unsigned int					m_Frame;
+
+	// feedback
+	unsigned int					m_FeedbackFBO, m_FeedbackColor, m_FeedbackDepth;
+	unsigned int					m_FeedbackPBO[2];
+	int								m_FeedbackWidth, m_FeedbackHeight;
+	int								m_FeedbackDivisor;
+	int								m_FeedbackIndex;
+	GLsync							m_FeedbackFence[2]; // readback in flight, nullptr if the PBO is free
+	int								m_Viewport[4];
+	int								m_PreviousDrawFBO, m_PreviousReadFBO;
+	float							m_PreviousClearColor[4];
+
+	// background tile loader
+	std::thread						m_Loader;
+	std::mutex						m_Mutex;
+	std::condition_variable			m_Condition;
+	std::deque<unsigned int>		m_Requests;
+	std::deque<LoadedTile>			m_Loaded;
+	bool							m_Running;
+
+public:
+	VirtualTexture(const std::string& path, int tileSize = 128, int cacheSide = 16, int feedbackDivisor = 8);
+	~VirtualTexture();
+
+	VirtualTexture(const VirtualTexture&) = delete;
+	VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+	// Renders into a small offscreen target, draw with VirtualTextureFeedback.shader in between
+	void BeginFeedback(int viewportWidth, int viewportHeight);
+	void EndFeedback();
+
+	// Uploads at most maxUploads finished tiles and refreshes the page table
+	void Update(unsigned int maxUploads = 8);
+
+	void Bind(unsigned int pageTableSlot = 0, unsigned int cacheSlot = 1) const;
+	void SetUniforms(Shader& shader, unsigned int pageTableSlot = 0, unsigned int cacheSlot = 1) const;
+
+	inline unsigned int GetResidentCount() const { return (unsigned int)m_Resident.size(); }
+	inline unsigned int GetPendingCount()  const { return (unsigned int)m_Pending.size();  }
+
+private:
+	void BuildMips(unsigned char* pixels, int width, int height);
+	void CreateFeedbackTarget(int width, int height);
+	void DeleteFeedbackTarget();
+	void ProcessFeedback(const unsigned char* pixels);
+	void RequestTile(unsigned int key);
+	void UploadTile(const LoadedTile& tile);
+	void RebuildPageTable();
+	void LoaderThread();
+	void ExtractTile(unsigned int key, std::vector<unsigned char>& out) const;
+
+	static unsigned int MakeKey(int x, int y, int mip) { return (unsigned int)mip << 16 | (unsigned int)y << 8 | (unsigned int)x; }
+};
@@ -0,0 +1,5 @@
+#pragma once
+
+// Checks run by starting the application with -test, once the GL context exists.
+// Each prints what it measured and returns the number of failures.
+int RunUniformAllocationTest();
@@ -0,0 +1,71 @@
+#include "Tests.h"
+
+#include <iostream>
+#include <atomic>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#endif
+
+#include "../src/Renderer.h"
+#include "../src/Shader.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+// Counts heap allocations while installed with _CrtSetAllocHook, only for the duration of a test so the rest of
+// the application keeps the plain debug heap
+static std::atomic<size_t> s_Allocations(0);
+
+static int CountAllocations(int allocType, void*, size_t, int blockType, long, const unsigned char*, int)
+{
+    //the CRT's own bookkeeping blocks aren't the code under test
+    if (blockType != _CRT_BLOCK && (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC))
+        s_Allocations.fetch_add(1, std::memory_order_relaxed);
+    return TRUE;
+}
+#endif
+
+// A frame's worth of uniform traffic must not allocate: names hashed in place, handles, changed and
+// unchanged values, then the flush that uploads them
+int RunUniformAllocationTest()
+{
+    static const int FrameCount = 60;
+
+    Shader shader("res/shaders/TextureArray.shader");
+    if (!shader.IsReady())
+    {
+        std::cout << "[Test] Uniform allocations: TextureArray.shader did not compile" << std::endl;
+        return 1;
+    }
+
+#if !defined(_MSC_VER) || !defined(_DEBUG)
+    std::cout << "[Test] Uniform allocations: needs the debug CRT's allocation hook, skipped" << std::endl;
+    return 0;
+#else
+    UniformHandle color = shader.GetUniform("u_Color");
+    shader.Bind();
+    shader.ResetUniformStats();
+
+    s_Allocations = 0;
+    _CRT_ALLOC_HOOK previousHook = _CrtSetAllocHook(CountAllocations);
+    for (int frame = 0; frame < FrameCount; frame++)
+    {
+        float t = frame * 0.1f;
+        shader.SetUniformMat4f("u_MVP", glm::translate(glm::mat4(1.0f), glm::vec3(t, 0.0f, 0.0f)));
+        shader.SetUniform4f(color, t, 0.5f, 0.5f, 1.0f);
+        shader.SetUniform1i("u_Layer", frame % 4);
+        shader.SetUniform1i("u_Textures", 0);
+        shader.FlushUniforms();
+    }
+    _CrtSetAllocHook(previousHook);
+    size_t allocations = s_Allocations.load();
+    shader.Unbind();
+
+    const UniformStats& stats = shader.GetUniformStats();
+    std::cout << "[Test] Uniform allocations: " << allocations << " over " << FrameCount << " frames ("
+              << stats.Writes << " writes, " << stats.Elided << " elided, " << stats.Uploads << " uploads) "
+              << (allocations == 0 ? "PASS" : "FAIL") << std::endl;
+    return allocations == 0 ? 0 : 1;
+#endif
+}